@@ -1,8 +1,10 @@
 #pragma once
 
-#include <cmath>
+#include <cstring>
+#include <string_view>
 #include <drops/drops.hpp>
 #include <eosio.system/eosio.system.hpp>
+#include <epoch.drops/uint64_to_chars.hpp>
 
 using namespace eosio;
 using namespace std;
@@ -11,6 +13,21 @@ static constexpr name drops_contract = "seed.gm"_n; // location of drops contrac
 
 static const string ERROR_SYSTEM_DISABLED = "Drops system is disabled.";
 
+static constexpr uint32_t MAX_ORACLES     = 1 << 16; // oracle slots are stored as uint16_t
+static constexpr uint64_t MAX_CHAIN_SKIP  = 32;      // epochs a hash chain reveal may skip over
+static constexpr uint32_t MAX_SEEDS_QUERY = 1000;    // epochs returned by a single getseeds call
+
+// epoch lifecycle status
+static constexpr uint8_t EPOCH_STATUS_COLLECTING = 0; // accepting commits
+static constexpr uint8_t EPOCH_STATUS_REVEALING  = 1; // ended, accepting reveals
+static constexpr uint8_t EPOCH_STATUS_COMPLETE   = 2; // seed computed from every reveal, or the first threshold reveals
+static constexpr uint8_t EPOCH_STATUS_FORCED     = 3; // seed salted by forcereveal or finalize
+static constexpr uint8_t EPOCH_STATUS_EMPTY      = 4; // finalized without reveals, no seed and no accumulator leaf
+
+// seed schemes, recorded per epoch
+static constexpr uint8_t SEED_VERSION_SORTED      = 1; // sha256 of the epoch and the sorted reveals
+static constexpr uint8_t SEED_VERSION_ACCUMULATED = 2; // sha256 of the sum of the reveals, folded in as they arrive
+
 namespace dropssystem {
 
 class [[eosio::contract("epoch.drops")]] epoch : public contract
@@ -18,23 +35,49 @@ class [[eosio::contract("epoch.drops")]] epoch : public contract
 public:
    using contract::contract;
 
-   struct [[eosio::table("commit")]] commit_row
+   /*
+    Tables. Their layouts are not binary compatible with the original release, and this contract cannot unpack the old
+    rows, not even to erase them. Before upgrading, clear the old tables with the contract that is still deployed
+    (make testnet/wipe/legacy), then deploy and run init again. make testnet/wipe clears the current layout.
+   */
+   // Merkle mountain range over completed epoch seeds, one peak per set bit of size from the highest subtree down
+   struct [[eosio::table("accumulator")]] accumulator_row
+   {
+      uint64_t            size = 0; // Number of seeds appended
+      vector<checksum256> peaks;
+   };
+
+   struct [[eosio::table("chain")]] chain_row
    {
-      uint64_t    id;
-      uint64_t    epoch;
       name        oracle;
+      checksum256 link;           // Last revealed link of the oracle's hash chain, or its registered tip
+      uint64_t    epoch;          // Epoch the link belongs to
+      uint64_t    stopped_at = 0; // Last epoch the chain still has to reveal after chainstop, 0 while active
+      uint64_t    primary_key() const { return oracle.value; }
+   };
+
+   // The epoch is the scope and the oracle is the slot of the epoch's oracle set, neither is stored again
+   struct [[eosio::table("commit")]] commit_row
+   {
+      uint64_t    id; // oracle slot, rows are scoped by epoch
       checksum256 commit;
       uint64_t    primary_key() const { return id; }
-      uint64_t    by_epoch() const { return epoch; }
-      uint128_t   by_epochoracle() const { return ((uint128_t)oracle.value << 64) | epoch; }
    };
 
    struct [[eosio::table("epoch")]] epoch_row
    {
-      uint64_t     epoch;
-      vector<name> oracles;
-      checksum256  seed;
-      uint64_t     primary_key() const { return epoch; }
+      uint64_t        epoch;
+      uint64_t        oracle_set; // Oracle set the epoch was created with
+      checksum256     seed;
+      uint32_t        commits = 0; // Number of oracles that committed to this epoch
+      uint32_t        reveals = 0; // Number of oracles that revealed for this epoch
+      vector<uint8_t> committed;   // Bitset of oracle slots that committed
+      vector<uint8_t> revealed;    // Bitset of oracle slots that revealed
+      uint8_t         status  = EPOCH_STATUS_COLLECTING;
+      uint64_t        leaf    = 0;                   // Position of the seed in the accumulator, set once complete
+      uint8_t         version = SEED_VERSION_SORTED; // Seed scheme the epoch was created with
+      checksum256     accumulator;                   // Sum of the reveals mod 2^256, SEED_VERSION_ACCUMULATED only
+      uint64_t        primary_key() const { return epoch; }
    };
 
    struct [[eosio::table("oracle")]] oracle_row
@@ -43,39 +86,54 @@ public:
       uint64_t primary_key() const { return oracle.value; }
    };
 
+   struct [[eosio::table("oracleset")]] oracleset_row
+   {
+      uint64_t     id;
+      vector<name> oracles;
+      uint64_t     primary_key() const { return id; }
+   };
+
    struct [[eosio::table("reveal")]] reveal_row
    {
-      uint64_t  id;
-      uint64_t  epoch;
-      name      oracle;
-      string    reveal;
-      uint64_t  primary_key() const { return id; }
-      uint64_t  by_epoch() const { return epoch; }
-      uint128_t by_epochoracle() const { return ((uint128_t)oracle.value << 64) | epoch; }
+      uint64_t    id; // oracle slot, rows are scoped by epoch
+      checksum256 reveal;
+      string      legacy; // Reveal string that is not 64 character lowercase hex, empty otherwise
+      uint64_t    primary_key() const { return id; }
+   };
+
+   // Epoch duration schedule, each segment applies from its first epoch until the next segment begins
+   struct [[eosio::table("segment")]] segment_row
+   {
+      uint64_t        epoch;    // First epoch of the segment
+      block_timestamp start;    // Start time of the first epoch
+      uint32_t        duration; // Duration of every epoch in the segment
+      uint64_t        primary_key() const { return epoch; }
    };
 
    struct [[eosio::table("state")]] state_row
    {
-      block_timestamp genesis  = current_block_time();
-      uint32_t        duration = 86400; // Epoch duration, 1-day default
-      bool            enabled  = false;
+      block_timestamp genesis    = current_block_time();
+      uint32_t        duration   = 86400; // Epoch duration, 1-day default
+      bool            enabled    = false;
+      uint64_t        oracle_set = 0;       // Current oracle set, 0 when no oracles are registered
+      vector<uint8_t> chained;              // Bitset of slots in the current oracle set with a registered hash chain
+      uint32_t        threshold    = 0;     // Reveals that finalize an epoch early, 0 waits for every committed oracle
+      uint32_t        grace_period = 86400; // Seconds after an epoch ends before anyone may finalize it
+      uint32_t        retention    = 0;     // Past epochs kept when pruning, 0 disables pruning
+      uint32_t        max_drops    = 5000;  // Drop ids accepted by a single scoredrops or topdrops call
+      // SEED_VERSION_* scheme used by newly created epochs
+      uint8_t         seed_version = SEED_VERSION_SORTED;
    };
 
-   typedef eosio::multi_index<"epoch"_n, epoch_row> epoch_table;
-   typedef eosio::multi_index<
-      "commit"_n,
-      commit_row,
-      eosio::indexed_by<"epoch"_n, eosio::const_mem_fun<commit_row, uint64_t, &commit_row::by_epoch>>,
-      eosio::indexed_by<"epochoracle"_n, eosio::const_mem_fun<commit_row, uint128_t, &commit_row::by_epochoracle>>>
-                                                      commit_table;
-   typedef eosio::multi_index<"oracle"_n, oracle_row> oracle_table;
-   typedef eosio::multi_index<
-      "reveal"_n,
-      reveal_row,
-      eosio::indexed_by<"epoch"_n, eosio::const_mem_fun<reveal_row, uint64_t, &reveal_row::by_epoch>>,
-      eosio::indexed_by<"epochoracle"_n, eosio::const_mem_fun<reveal_row, uint128_t, &reveal_row::by_epochoracle>>>
-                                                  reveal_table;
-   typedef eosio::singleton<"state"_n, state_row> state_table;
+   typedef eosio::singleton<"accumulator"_n, accumulator_row> accumulator_table;
+   typedef eosio::multi_index<"chain"_n, chain_row>           chain_table;
+   typedef eosio::multi_index<"epoch"_n, epoch_row>           epoch_table;
+   typedef eosio::multi_index<"commit"_n, commit_row>         commit_table;
+   typedef eosio::multi_index<"oracle"_n, oracle_row>         oracle_table;
+   typedef eosio::multi_index<"oracleset"_n, oracleset_row>   oracleset_table;
+   typedef eosio::multi_index<"reveal"_n, reveal_row>         reveal_table;
+   typedef eosio::multi_index<"segment"_n, segment_row>       segment_table;
+   typedef eosio::singleton<"state"_n, state_row>             state_table;
 
    /*
     Oracle actions
@@ -86,12 +144,54 @@ public:
    [[eosio::action]] void reveal(const name oracle, const uint64_t epoch, const string reveal);
    using reveal_action = eosio::action_wrapper<"reveal"_n, &epoch::reveal>;
 
+   [[eosio::action]] void revealbin(const name oracle, const uint64_t epoch, const checksum256 reveal);
+   using revealbin_action = eosio::action_wrapper<"revealbin"_n, &epoch::revealbin>;
+
+   // Reveal (binary) for the previous epoch and commit to the current epoch in a single action
+   [[eosio::action]] void
+   commitreveal(const name oracle, const uint64_t epoch, const checksum256 commit, const checksum256 reveal);
+   using commitreveal_action = eosio::action_wrapper<"commitreveal"_n, &epoch::commitreveal>;
+
+   /*
+    Hash chain actions, an oracle registers the tip of a hash chain once and then reveals one preimage per epoch
+    instead of committing every epoch. Stopping a chain keeps it until the epochs it was committed to are revealed.
+   */
+   [[eosio::action]] void chaininit(const name oracle, const checksum256 tip);
+   using chaininit_action = eosio::action_wrapper<"chaininit"_n, &epoch::chaininit>;
+
+   [[eosio::action]] void chainreveal(const name oracle, const uint64_t epoch, const checksum256 reveal);
+   using chainreveal_action = eosio::action_wrapper<"chainreveal"_n, &epoch::chainreveal>;
+
+   [[eosio::action]] void chainstop(const name oracle);
+   using chainstop_action = eosio::action_wrapper<"chainstop"_n, &epoch::chainstop>;
+
    [[eosio::action]] void forcereveal(const uint64_t epoch, const string salt);
    using forcereveal_action = eosio::action_wrapper<"forcereveal"_n, &epoch::forcereveal>;
 
+   // Permissionless, finalizes a stalled epoch once its grace period has passed and erases up to max_rows leftovers,
+   // an epoch without reveals is closed as EPOCH_STATUS_EMPTY
+   [[eosio::action]] void finalize(const uint64_t epoch, const uint32_t max_rows);
+   using finalize_action = eosio::action_wrapper<"finalize"_n, &epoch::finalize>;
+
+   // Permissionless, erases up to max_rows of the oldest finished epochs outside of the retention window and then
+   // the oracle sets no remaining epoch uses. Empty epochs and ended epochs nobody committed to count as finished.
+   // Every addoracle and removeoracle publishes a new set, only pruning reclaims the old ones.
+   [[eosio::action]] void prune(const uint32_t max_rows);
+   using prune_action = eosio::action_wrapper<"prune"_n, &epoch::prune>;
+
    [[eosio::action, eosio::read_only]] checksum256 computehash(const uint64_t epoch, const vector<string> reveals);
    using computehash_action = eosio::action_wrapper<"computehash"_n, &epoch::computehash>;
 
+   // Seed of a SEED_VERSION_ACCUMULATED epoch from its reveals, in any order
+   [[eosio::action, eosio::read_only]] checksum256 computehash2(const uint64_t            epoch,
+                                                                const vector<checksum256> reveals);
+   using computehash2_action = eosio::action_wrapper<"computehash2"_n, &epoch::computehash2>;
+
+   // Verifies a historical seed against the accumulator, proof holds the sibling hashes from the leaf up to its peak
+   [[eosio::action, eosio::read_only]] bool
+   verifyseed(const uint64_t epoch, const checksum256 seed, const uint64_t leaf, const vector<checksum256> proof);
+   using verifyseed_action = eosio::action_wrapper<"verifyseed"_n, &epoch::verifyseed>;
+
    struct epoch_info
    {
       uint64_t        epoch;
@@ -107,6 +207,35 @@ public:
    [[eosio::action, eosio::read_only]] epoch_info getepochinfo(const optional<uint64_t> epoch);
    using getepochinfo_action = eosio::action_wrapper<"getepochinfo"_n, &epoch::getepochinfo>;
 
+   struct seed_info
+   {
+      uint64_t        epoch;
+      block_timestamp start;
+      block_timestamp end;
+      checksum256     seed;
+      uint8_t         status;
+   };
+
+   // Existing epochs from start_epoch onwards, skipped and pruned epochs are left out
+   [[eosio::action, eosio::read_only]] vector<seed_info> getseeds(const uint64_t start_epoch, const uint32_t limit);
+   using getseeds_action = eosio::action_wrapper<"getseeds"_n, &epoch::getseeds>;
+
+   struct drop_score
+   {
+      uint64_t    drop;
+      checksum256 hash;  // hashdrop of the drop against the epoch seed
+      uint16_t    zeros; // Leading zero bits of the hash
+   };
+
+   [[eosio::action, eosio::read_only]] vector<drop_score> scoredrops(const uint64_t         epoch,
+                                                                    const vector<uint64_t> drops);
+   using scoredrops_action = eosio::action_wrapper<"scoredrops"_n, &epoch::scoredrops>;
+
+   // The k drops with the most leading zero bits, best first, ties go to the lower hash
+   [[eosio::action, eosio::read_only]] vector<drop_score>
+   topdrops(const uint64_t epoch, const vector<uint64_t> drops, const uint32_t k);
+   using topdrops_action = eosio::action_wrapper<"topdrops"_n, &epoch::topdrops>;
+
    [[eosio::action, eosio::read_only]] vector<name> getoracles();
    using getoracles_action = eosio::action_wrapper<"getoracles"_n, &epoch::getoracles>;
 
@@ -128,6 +257,21 @@ public:
    [[eosio::action]] void duration(const uint32_t duration);
    using duration_action = eosio::action_wrapper<"duration"_n, &epoch::duration>;
 
+   [[eosio::action]] void threshold(const uint32_t threshold);
+   using threshold_action = eosio::action_wrapper<"threshold"_n, &epoch::threshold>;
+
+   [[eosio::action]] void graceperiod(const uint32_t grace_period);
+   using graceperiod_action = eosio::action_wrapper<"graceperiod"_n, &epoch::graceperiod>;
+
+   [[eosio::action]] void retention(const uint32_t retention);
+   using retention_action = eosio::action_wrapper<"retention"_n, &epoch::retention>;
+
+   [[eosio::action]] void maxdrops(const uint32_t max_drops);
+   using maxdrops_action = eosio::action_wrapper<"maxdrops"_n, &epoch::maxdrops>;
+
+   [[eosio::action]] void seedversion(const uint8_t seed_version);
+   using seedversion_action = eosio::action_wrapper<"seedversion"_n, &epoch::seedversion>;
+
    [[eosio::action]] epoch_row advance();
    using advance_action = eosio::action_wrapper<"advance"_n, &epoch::advance>;
 
@@ -136,9 +280,37 @@ public:
    */
    static constexpr char hexmap[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
 
+   static bool has_slot(const vector<uint8_t>& bitset, const uint16_t slot)
+   {
+      return slot / 8 < bitset.size() && (bitset[slot / 8] >> (slot % 8)) & 1;
+   }
+
+   static void set_slot(vector<uint8_t>& bitset, const uint16_t slot)
+   {
+      if (slot / 8 >= bitset.size())
+         bitset.resize(slot / 8 + 1);
+      bitset[slot / 8] |= 1 << (slot % 8);
+   }
+
+   static void clear_slot(vector<uint8_t>& bitset, const uint16_t slot)
+   {
+      if (slot / 8 < bitset.size())
+         bitset[slot / 8] &= ~(1 << (slot % 8));
+   }
+
+   static uint32_t count_slots(const vector<uint8_t>& bitset)
+   {
+      uint32_t count = 0;
+      for (uint8_t byte : bitset) {
+         for (; byte; byte &= byte - 1)
+            count++;
+      }
+      return count;
+   }
+
    static uint64_t derive_epoch(const block_timestamp genesis, const uint32_t duration)
    {
-      return floor((current_time_point().sec_since_epoch() - genesis.to_time_point().sec_since_epoch()) / duration) + 1;
+      return (current_time_point().sec_since_epoch() - genesis.to_time_point().sec_since_epoch()) / duration + 1;
    }
 
    static block_timestamp
@@ -148,20 +320,68 @@ public:
       return block_timestamp(genesis.to_time_point() + seconds(duration * (epoch - 1)));
    }
 
+   // Writes len * 2 lowercase hex characters into out, which the caller sizes
+   static void hex_encode(const unsigned char* data, const size_t len, char* out)
+   {
+      for (size_t i = 0; i < len; ++i) {
+         out[2 * i]     = hexmap[(data[i] & 0xF0) >> 4];
+         out[2 * i + 1] = hexmap[data[i] & 0x0F];
+      }
+   }
+
    static string hex_to_str(const unsigned char* data, const int len)
    {
       string s(len * 2, ' ');
-      for (int i = 0; i < len; ++i) {
-         s[2 * i]     = hexmap[(data[i] & 0xF0) >> 4];
-         s[2 * i + 1] = hexmap[data[i] & 0x0F];
-      }
+      hex_encode(data, len, &s[0]);
       return s;
    }
 
+   // Fixed buffer form of checksum256_to_string, nothing is allocated
+   static array<char, 64> checksum256_to_hex(const checksum256& checksum)
+   {
+      array<char, 64> hex;
+      const auto      byte_array = checksum.extract_as_byte_array();
+      hex_encode(byte_array.data(), byte_array.size(), hex.data());
+      return hex;
+   }
+
    static string checksum256_to_string(const checksum256& checksum)
    {
-      auto byte_array = checksum.extract_as_byte_array();
-      return hex_to_str(byte_array.data(), byte_array.size());
+      const array<char, 64> hex = checksum256_to_hex(checksum);
+      return string(hex.data(), hex.size());
+   }
+
+   static uint8_t hex_to_nibble(const char c)
+   {
+      if (c >= '0' && c <= '9')
+         return c - '0';
+      if (c >= 'a' && c <= 'f')
+         return c - 'a' + 10;
+      check(false, "Reveal must be a 64 character lowercase hex string.");
+      return 0;
+   }
+
+   // True when hex_to_checksum256 round trips the string, anything else is revealed as a legacy string
+   static bool is_hex_checksum256(const string& hex)
+   {
+      if (hex.length() != 64)
+         return false;
+      for (const char c : hex) {
+         if (!(c >= '0' && c <= '9') && !(c >= 'a' && c <= 'f'))
+            return false;
+      }
+      return true;
+   }
+
+   // Inverse of checksum256_to_string, only lowercase hex round trips to the same string
+   static checksum256 hex_to_checksum256(const string& hex)
+   {
+      check(hex.length() == 64, "Reveal must be a 64 character lowercase hex string.");
+      array<uint8_t, 32> bytes;
+      for (size_t i = 0; i < bytes.size(); ++i) {
+         bytes[i] = (hex_to_nibble(hex[2 * i]) << 4) | hex_to_nibble(hex[2 * i + 1]);
+      }
+      return checksum256(bytes);
    }
 
    static uint16_t clzhex(const std::string& hexString)
@@ -213,24 +433,109 @@ public:
       return lzbits;
    }
 
+   // Adds two checksums as 256-bit big endian integers, wrapping around on overflow
+   static checksum256 add_checksum256(const checksum256 a, const checksum256 b)
+   {
+      const auto         a_bytes = a.extract_as_byte_array();
+      const auto         b_bytes = b.extract_as_byte_array();
+      array<uint8_t, 32> sum;
+      uint16_t           carry = 0;
+      for (int i = 31; i >= 0; --i) {
+         carry += a_bytes[i] + b_bytes[i];
+         sum[i] = carry & 0xff;
+         carry >>= 8;
+      }
+      return checksum256(sum);
+   }
+
+   static checksum256 hash_seed_v2(const uint64_t epoch, const checksum256 accumulator)
+   {
+      // Domain tag, little endian epoch, then the raw accumulator bytes
+      static constexpr char tag[] = "epoch.drops:seed:v2";
+      char                  data[sizeof(tag) - 1 + 8 + 32];
+      const auto            accumulator_bytes = accumulator.extract_as_byte_array();
+      memcpy(data, tag, sizeof(tag) - 1);
+      for (int i = 0; i < 8; i++)
+         data[sizeof(tag) - 1 + i] = (epoch >> (8 * i)) & 0xff;
+      memcpy(data + sizeof(tag) - 1 + 8, accumulator_bytes.data(), 32);
+      return sha256(data, sizeof(data));
+   }
+
+   // Value a legacy string reveal adds to the accumulator, the commit is the plain sha256 so it needs its own tag
+   static checksum256 hash_legacy_reveal(const string& reveal)
+   {
+      const string data = "epoch.drops:legacy:" + reveal;
+      return sha256(data.c_str(), data.length());
+   }
+
+   static checksum256 hash_seed_leaf(const uint64_t epoch, const checksum256 seed)
+   {
+      // Little endian epoch followed by the raw seed bytes
+      char       data[40];
+      const auto seed_bytes = seed.extract_as_byte_array();
+      for (int i = 0; i < 8; i++)
+         data[i] = (epoch >> (8 * i)) & 0xff;
+      memcpy(data + 8, seed_bytes.data(), 32);
+      return sha256(data, sizeof(data));
+   }
+
+   static checksum256 hash_seed_node(const checksum256 left, const checksum256 right)
+   {
+      char       data[64];
+      const auto left_bytes  = left.extract_as_byte_array();
+      const auto right_bytes = right.extract_as_byte_array();
+      memcpy(data, left_bytes.data(), 32);
+      memcpy(data + 32, right_bytes.data(), 32);
+      return sha256(data, sizeof(data));
+   }
+
    static checksum256 hash(const checksum256 epochseed, const string data)
    {
-      string result = checksum256_to_string(epochseed) + data;
-      return sha256(result.c_str(), result.length());
+      string buffer;
+      return hash(checksum256_to_hex(epochseed), data, buffer);
    }
 
    static checksum256 hashdrop(const checksum256 epochseed, const uint64_t drops_id)
    {
-      return hash(epochseed, to_string(drops_id));
+      return hashdrop(checksum256_to_hex(epochseed), drops_id);
    }
 
    static checksum256 hashdrops(const checksum256 epochseed, const vector<uint64_t> drops_ids)
    {
-      string data = "";
+      string buffer;
+      return hashdrops(checksum256_to_hex(epochseed), drops_ids, buffer);
+   }
+
+   /*
+    Buffer overloads of hash, hashdrop and hashdrops with identical output, the seed is hex encoded once by the caller
+    with checksum256_to_hex and a caller owned buffer keeps its capacity between calls
+   */
+   static checksum256 hash(const array<char, 64>& seed_hex, const string_view data, string& buffer)
+   {
+      buffer.assign(seed_hex.data(), seed_hex.size());
+      buffer.append(data.data(), data.size());
+      return sha256(buffer.data(), buffer.size());
+   }
+
+   static checksum256 hashdrop(const array<char, 64>& seed_hex, const uint64_t drops_id)
+   {
+      char data[64 + 20];
+      memcpy(data, seed_hex.data(), seed_hex.size());
+      const size_t length = seed_hex.size() + uint64_to_chars(drops_id, data + seed_hex.size());
+      return sha256(data, length);
+   }
+
+   static checksum256 hashdrops(const array<char, 64>& seed_hex, const vector<uint64_t>& drops_ids, string& buffer)
+   {
+      buffer.assign(seed_hex.data(), seed_hex.size());
+      buffer.resize(seed_hex.size() + drops_ids.size() * 20);
+
+      size_t length = seed_hex.size();
       for (const auto& id : drops_ids)
-         data += to_string(id);
+         length += uint64_to_chars(id, &buffer[length]);
 
-      return hash(epochseed, data);
+      buffer.resize(length);
+      return sha256(buffer.data(), buffer.size());
    }
 
 // DEBUG (used to help testing)
@@ -243,31 +548,94 @@ public:
 #endif
 
 private:
-   void check_is_enabled();
-
-   epoch::epoch_row    advance_epoch();
-   void                ensure_epoch_advance(const uint64_t epoch);
-   void                ensure_epoch_reveal(const uint64_t epoch);
-   void                cleanup_epoch(const uint64_t epoch, const vector<name> oracles);
-   void                remove_oracle_commit(const uint64_t epoch, const name oracle);
-   void                remove_oracle_reveal(const uint64_t epoch, const name oracle);
-   bool                oracle_has_committed(const name oracle, const uint64_t epoch);
-   bool                oracle_has_revealed(const name oracle, const uint64_t epoch);
-   void                complete_epoch(const uint64_t epoch, const checksum256 epoch_seed);
-   vector<name>        get_active_oracles();
+   // Request-scoped cache of the state singleton and epoch table, loaded at most once per action
+   struct context
+   {
+      context(const name self)
+       : epochs(self, self.value)
+       , segments(self, self.value)
+       , oraclesets(self, self.value)
+      {
+         state_table _state(self, self.value);
+         state = _state.get_or_default();
+
+         // Only the latest segment, or one scheduled for the next epoch before it, needs to be looked at
+         current_segment = {1, state.genesis, state.duration};
+         for (auto itr = segments.rbegin(); itr != segments.rend(); itr++) {
+            if (itr->start.to_time_point() <= current_time_point()) {
+               current_segment = *itr;
+               break;
+            }
+         }
+         current_epoch_height =
+            current_segment.epoch + derive_epoch(current_segment.start, current_segment.duration) - 1;
+      }
+
+      state_row       state;
+      segment_row     current_segment;
+      uint64_t        current_epoch_height;
+      epoch_table     epochs;
+      segment_table   segments;
+      oracleset_table oraclesets;
+   };
+
+   void check_is_enabled(const context& ctx);
+
+   epoch::epoch_row    advance_epoch(context& ctx);
+   void                ensure_epoch_advance(context& ctx);
+   void                ensure_epoch_reveal(context& ctx, const epoch_row& epoch_row);
+   uint16_t            submit_commit(context& ctx, const name oracle, const uint64_t epoch, const checksum256 commit);
+   void                submit_reveal(context&          ctx,
+                                     const name        oracle,
+                                     const epoch_row&  epoch_row,
+                                     const uint16_t    slot,
+                                     const checksum256 reveal);
+   commit_row          prepare_reveal(context& ctx, const epoch_row& epoch_row, const uint16_t slot);
+   uint64_t            cleanup_epoch(const uint64_t epoch, const uint64_t max_rows = UINT64_MAX);
+   string              get_finalize_salt(const uint64_t epoch);
+   uint16_t            get_oracle_slot(const context& ctx, const epoch_row& epoch_row, const name oracle);
+   optional<uint16_t>  find_oracle_slot(const context& ctx, const epoch_row& epoch_row, const name oracle);
+   void                complete_epoch(context&          ctx,
+                                      const epoch_row&  epoch_row,
+                                      const checksum256 epoch_seed,
+                                      const uint8_t     status);
+   uint64_t            get_active_oracle_set(const context& ctx);
+   const vector<name>& get_oracle_set(const context& ctx, const uint64_t oracle_set);
+   void                publish_oracle_set();
+   uint64_t            append_seed(const uint64_t epoch, const checksum256 seed);
+   checksum256         get_epoch_seed(context& ctx, const uint64_t epoch);
    vector<string>      get_epoch_reveals(const uint64_t epoch);
-   vector<checksum256> get_epoch_commits(const uint64_t epoch);
-   uint64_t            get_current_epoch_height();
-   epoch_row           get_epoch(const uint64_t epoch);
-   reveal_row          get_reveal(const name oracle, const uint64_t epoch);
-   commit_row          get_commit(name const oracle, const uint64_t epoch);
-
-   void emplace_commit(const uint64_t epoch, const name oracle, const checksum256 commit);
-   void emplace_reveal(const uint64_t epoch, const name oracle, const string reveal);
+   checksum256         compute_epoch_seed(const uint64_t epoch);
+   checksum256         compute_salted_seed(const epoch_row& epoch_row, const string& salt);
+   const epoch_row&    get_epoch(context& ctx, const uint64_t epoch);
+   bool                is_skipped_epoch(const context& ctx, const uint64_t epoch);
+   segment_row         get_segment(const context& ctx, const uint64_t epoch);
+   block_timestamp     get_epoch_start(const context& ctx, const uint64_t epoch);
+   commit_row          get_commit(const uint64_t epoch, const uint16_t slot);
+
+   void emplace_commit(
+      context& ctx, const epoch_row& epoch_row, const uint16_t slot, const name oracle, const checksum256 commit);
+   void emplace_reveal(context&          ctx,
+                       const epoch_row&  epoch_row,
+                       const uint16_t    slot,
+                       const name        oracle,
+                       const checksum256 reveal,
+                       const string&     legacy = "");
+
+   // Range helpers over the epoch scope of the commit and reveal tables
+   template <typename T, typename F>
+   void for_each_in_epoch(const uint64_t epoch, F&& callback);
+   template <typename T>
+   bool is_empty_epoch(const uint64_t epoch);
+   template <typename F>
+   void score_drops(const context& ctx, const checksum256 seed, const vector<uint64_t>& drops, F&& callback);
+   template <typename T>
+   uint64_t erase_in_epoch(const uint64_t epoch, const uint64_t max_rows = UINT64_MAX);
+
 // DEBUG (used to help testing)
 #ifdef DEBUG
    template <typename T>
-   void clear_table(T& table, uint64_t rows_to_clear);
+   uint64_t clear_table(T& table, uint64_t rows_to_clear);
 #endif
 };
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dropssystem {
+
+// Two decimal digits for every value from 0 to 99
+static constexpr char digit_pairs[] = "0001020304050607080910111213141516171819"
+                                      "2021222324252627282930313233343536373839"
+                                      "4041424344454647484950515253545556575859"
+                                      "6061626364656667686970717273747576777879"
+                                      "8081828384858687888990919293949596979899";
+
+// Writes the decimal digits of value into out, which must hold at least 20 characters, and returns their count.
+// Same digits as to_string, two at a time from the back so only half the divisions are needed. Kept free of eosio
+// headers so test/uint64_to_chars.cpp can check it natively.
+static constexpr size_t uint64_to_chars(uint64_t value, char* out)
+{
+   size_t length = 1;
+   for (uint64_t bound = 10; length < 20 && value >= bound; bound *= 10)
+      length++;
+
+   size_t pos = length;
+   while (value >= 100) {
+      const size_t pair = (value % 100) * 2;
+      value /= 100;
+      out[--pos] = digit_pairs[pair + 1];
+      out[--pos] = digit_pairs[pair];
+   }
+   if (value >= 10) {
+      out[--pos] = digit_pairs[value * 2 + 1];
+      out[--pos] = digit_pairs[value * 2];
+   } else {
+      out[--pos] = '0' + value;
+   }
+   return length;
+}
+
+} // namespace dropssystem
@@ -5,12 +5,15 @@ namespace dropssystem {
 
 // @debug
 template <typename T>
-void epoch::clear_table(T& table, uint64_t rows_to_clear)
+uint64_t epoch::clear_table(T& table, uint64_t rows_to_clear)
 {
-   auto itr = table.begin();
-   while (itr != table.end() && rows_to_clear--) {
+   uint64_t cleared = 0;
+   auto     itr     = table.begin();
+   while (itr != table.end() && cleared < rows_to_clear) {
       itr = table.erase(itr);
+      cleared++;
    }
+   return cleared;
 }
 
 // @debug
@@ -22,25 +25,45 @@ epoch::cleartable(const name table_name, const optional<name> scope, const optio
    const uint64_t value         = scope ? scope->value : get_self().value;
 
    // tables
-   epoch::commit_table _commit(get_self(), value);
-   epoch::epoch_table  _epoch(get_self(), value);
-   epoch::oracle_table _oracle(get_self(), value);
-   epoch::reveal_table _reveal(get_self(), value);
-   epoch::state_table  _state(get_self(), value);
+   epoch::accumulator_table _accumulator(get_self(), value);
+   epoch::chain_table       _chain(get_self(), value);
+   epoch::commit_table      _commit(get_self(), value);
+   epoch::epoch_table       _epoch(get_self(), value);
+   epoch::oracle_table      _oracle(get_self(), value);
+   epoch::oracleset_table   _oracleset(get_self(), value);
+   epoch::reveal_table      _reveal(get_self(), value);
+   epoch::segment_table     _segment(get_self(), value);
+   epoch::state_table       _state(get_self(), value);
    //    epoch::subscriber_table _subscriber(get_self(), value);
 
-   if (table_name == "commit"_n)
+   // Commit and reveal rows are scoped by epoch, without a scope the scopes of every known epoch are cleared
+   if ((table_name == "commit"_n || table_name == "reveal"_n) && !scope) {
+      uint64_t remaining = rows_to_clear;
+      for (auto itr = _epoch.begin(); itr != _epoch.end() && remaining > 0; itr++) {
+         epoch::commit_table commits(get_self(), itr->epoch);
+         epoch::reveal_table reveals(get_self(), itr->epoch);
+         remaining -= table_name == "commit"_n ? clear_table(commits, remaining) : clear_table(reveals, remaining);
+      }
+   } else if (table_name == "chain"_n)
+      clear_table(_chain, rows_to_clear);
+   else if (table_name == "commit"_n)
       clear_table(_commit, rows_to_clear);
    else if (table_name == "epoch"_n)
       clear_table(_epoch, rows_to_clear);
    else if (table_name == "oracle"_n)
       clear_table(_oracle, rows_to_clear);
+   else if (table_name == "oracleset"_n)
+      clear_table(_oracleset, rows_to_clear);
    else if (table_name == "reveal"_n)
       clear_table(_reveal, rows_to_clear);
+   else if (table_name == "segment"_n)
+      clear_table(_segment, rows_to_clear);
    //    else if (table_name == "subscriber"_n)
    //       clear_table(_subscriber, rows_to_clear);
    else if (table_name == "state"_n)
       _state.remove();
+   else if (table_name == "accumulator"_n)
+      _accumulator.remove();
    else
       check(false, "cleartable: [table_name] unknown table to clear");
 }
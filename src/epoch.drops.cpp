@@ -10,181 +10,542 @@ namespace dropssystem {
 [[eosio::action]] void epoch::commit(const name oracle, const uint64_t epoch, const checksum256 commit)
 {
    require_auth(oracle);
-   check_is_enabled();
+   context ctx(get_self());
+   check_is_enabled(ctx);
 
-   const uint64_t current_epoch_height = get_current_epoch_height();
-   check(epoch == current_epoch_height, "Epoch submitted (" + to_string(epoch) + ") is not the current epoch (" +
-                                           to_string(current_epoch_height) + ").");
+   submit_commit(ctx, oracle, epoch, commit);
+}
 
-   ensure_epoch_advance(current_epoch_height);
+[[eosio::action]] void epoch::reveal(const name oracle, const uint64_t epoch, const string reveal)
+{
+   require_auth(oracle);
+   context ctx(get_self());
+   check_is_enabled(ctx);
+
+   const epoch::epoch_row& _epoch      = get_epoch(ctx, epoch);
+   const commit_row        _commit     = prepare_reveal(ctx, _epoch, get_oracle_slot(ctx, _epoch, oracle));
+   const checksum256       commit_hash = _commit.commit;
+   const checksum256       reveal_hash = sha256(reveal.c_str(), reveal.length());
+
+   // Error messages are only formatted once the check has already failed
+   if (reveal_hash != commit_hash) {
+      check(false, "Reveal value '" + reveal + "' hashes to '" + checksum256_to_string(reveal_hash) +
+                      "' which does not match commit value '" + checksum256_to_string(commit_hash) + "'.");
+   }
 
-   const epoch::epoch_row _epoch = get_epoch(epoch);
-   check(find(_epoch.oracles.begin(), _epoch.oracles.end(), oracle) != _epoch.oracles.end(),
-         "Oracle is not in the list of oracles for Epoch " + to_string(epoch) + ".");
-   check(!oracle_has_committed(oracle, epoch), "Oracle has already committed");
+   // Hex reveals are stored in their binary form, which encodes back to the same string. Any other secret that was
+   // committed to is kept as its original string so the oracle can always reveal it.
+   if (is_hex_checksum256(reveal)) {
+      emplace_reveal(ctx, _epoch, _commit.id, oracle, hex_to_checksum256(reveal));
+   } else {
+      emplace_reveal(ctx, _epoch, _commit.id, oracle, hash_legacy_reveal(reveal), reveal);
+   }
 
-   emplace_commit(epoch, oracle, commit);
+   ensure_epoch_reveal(ctx, _epoch);
 }
 
-[[eosio::action]] void epoch::reveal(const name oracle, const uint64_t epoch, const string reveal)
+[[eosio::action]] void epoch::revealbin(const name oracle, const uint64_t epoch, const checksum256 reveal)
 {
    require_auth(oracle);
-   check_is_enabled();
+   context ctx(get_self());
+   check_is_enabled(ctx);
 
-   const epoch::epoch_row _epoch = get_epoch(epoch);
-   check(find(_epoch.oracles.begin(), _epoch.oracles.end(), oracle) != _epoch.oracles.end(),
-         "Oracle is not in the list of oracles for Epoch " + to_string(epoch) + ".");
+   const epoch::epoch_row& _epoch = get_epoch(ctx, epoch);
+   submit_reveal(ctx, oracle, _epoch, get_oracle_slot(ctx, _epoch, oracle), reveal);
+}
 
-   const uint64_t current_epoch_height = get_current_epoch_height();
-   check(epoch < current_epoch_height, "Epoch (" + to_string(epoch) + ") has not completed.");
+[[eosio::action]] void
+epoch::commitreveal(const name oracle, const uint64_t epoch, const checksum256 commit, const checksum256 reveal)
+{
+   require_auth(oracle);
+   context ctx(get_self());
+   check_is_enabled(ctx);
 
-   ensure_epoch_advance(current_epoch_height);
+   // Commit to the current epoch first, so a reveal that is no longer needed never costs the oracle its commit
+   const uint16_t slot = submit_commit(ctx, oracle, epoch, commit);
+   if (epoch <= 1) {
+      check(false, "Epoch (" + to_string(epoch) + ") has no previous epoch to reveal.");
+   }
 
-   check(!oracle_has_revealed(oracle, epoch), "Oracle has already revealed");
+   // Reveal for the epoch that just ended, unless it already completed or the oracle has nothing to reveal there
+   const auto previous_itr = ctx.epochs.find(epoch - 1);
+   if (previous_itr == ctx.epochs.end() || previous_itr->status >= EPOCH_STATUS_COMPLETE) {
+      return;
+   }
 
-   const commit_row  _commit     = get_commit(oracle, epoch);
-   const checksum256 commit_hash = _commit.commit;
-   const string      commit_str  = checksum256_to_string(commit_hash);
+   // The slot only has to be looked up again when the oracle set changed between the two epochs
+   const optional<uint16_t> previous_slot = previous_itr->oracle_set == get_epoch(ctx, epoch).oracle_set
+                                               ? slot
+                                               : find_oracle_slot(ctx, *previous_itr, oracle);
+   if (!previous_slot || has_slot(previous_itr->revealed, *previous_slot)) {
+      return;
+   }
+   const epoch::commit_table commits(get_self(), epoch - 1);
+   if (commits.find(*previous_slot) != commits.end()) {
+      submit_reveal(ctx, oracle, *previous_itr, *previous_slot, reveal);
+   }
+}
 
-   const checksum256 reveal_hash = sha256(reveal.c_str(), reveal.length());
-   const string      reveal_str  = checksum256_to_string(reveal_hash);
+uint16_t epoch::submit_commit(context& ctx, const name oracle, const uint64_t epoch, const checksum256 commit)
+{
+   const uint64_t current_epoch_height = ctx.current_epoch_height;
+   if (epoch != current_epoch_height) {
+      check(false, "Epoch submitted (" + to_string(epoch) + ") is not the current epoch (" +
+                      to_string(current_epoch_height) + ").");
+   }
+
+   ensure_epoch_advance(ctx);
+
+   const epoch::epoch_row& _epoch = get_epoch(ctx, epoch);
+   const uint16_t          slot   = get_oracle_slot(ctx, _epoch, oracle);
+   check(!has_slot(_epoch.committed, slot), "Oracle has already committed");
+
+   emplace_commit(ctx, _epoch, slot, oracle, commit);
+   return slot;
+}
+
+void epoch::submit_reveal(
+   context& ctx, const name oracle, const epoch_row& epoch_row, const uint16_t slot, const checksum256 reveal)
+{
+   const commit_row  _commit      = prepare_reveal(ctx, epoch_row, slot);
+   const checksum256 commit_hash  = _commit.commit;
+   const auto        reveal_bytes = reveal.extract_as_byte_array();
+   const checksum256 reveal_hash  = sha256((const char*)reveal_bytes.data(), reveal_bytes.size());
+
+   if (reveal_hash != commit_hash) {
+      check(false, "Reveal value '" + checksum256_to_string(reveal) + "' hashes to '" +
+                      checksum256_to_string(reveal_hash) + "' which does not match commit value '" +
+                      checksum256_to_string(commit_hash) + "'.");
+   }
 
-   check(reveal_hash == commit_hash, "Reveal value '" + reveal + "' hashes to '" + reveal_str +
-                                        "' which does not match commit value '" + commit_str + "'.");
+   emplace_reveal(ctx, epoch_row, _commit.id, oracle, reveal);
 
-   emplace_reveal(epoch, oracle, reveal);
+   ensure_epoch_reveal(ctx, epoch_row);
+}
+
+[[eosio::action]] void epoch::chaininit(const name oracle, const checksum256 tip)
+{
+   require_auth(oracle);
+   context ctx(get_self());
+   check_is_enabled(ctx);
+
+   // Create the current epoch first, the chain only commits the oracle to epochs created after registration
+   ensure_epoch_advance(ctx);
+
+   const vector<name>& oracles    = get_oracle_set(ctx, get_active_oracle_set(ctx));
+   const auto          oracle_itr = find(oracles.begin(), oracles.end(), oracle);
+   check(oracle_itr != oracles.end(), "Oracle is not in the current oracle set.");
+
+   // The chain commits the oracle from the next epoch onwards, the current epoch still needs a regular commit
+   epoch::chain_table chains(get_self(), get_self().value);
+   const auto         chain_itr = chains.find(oracle.value);
+   if (chain_itr == chains.end()) {
+      chains.emplace(oracle, [&](auto& row) {
+         row.oracle = oracle;
+         row.link   = tip;
+         row.epoch  = ctx.current_epoch_height;
+      });
+   } else {
+      // A new tip cannot reveal the epochs the previous chain is still committed to
+      const uint64_t last_epoch = chain_itr->stopped_at ? chain_itr->stopped_at : ctx.current_epoch_height;
+      for (auto itr = ctx.epochs.upper_bound(chain_itr->epoch); itr != ctx.epochs.end() && itr->epoch <= last_epoch;
+           ++itr) {
+         if (itr->status >= EPOCH_STATUS_COMPLETE) {
+            continue;
+         }
+         const optional<uint16_t> slot = find_oracle_slot(ctx, *itr, oracle);
+         if (slot && has_slot(itr->committed, *slot) && !has_slot(itr->revealed, *slot)) {
+            check(false, "Hash chain has not been revealed for Epoch " + to_string(itr->epoch) + ".");
+         }
+      }
+      chains.modify(chain_itr, oracle, [&](auto& row) {
+         row.link       = tip;
+         row.epoch      = ctx.current_epoch_height;
+         row.stopped_at = 0;
+      });
+   }
 
-   ensure_epoch_reveal(epoch);
+   set_slot(ctx.state.chained, oracle_itr - oracles.begin());
+   epoch::state_table _state(get_self(), get_self().value);
+   _state.set(ctx.state, get_self());
+}
+
+[[eosio::action]] void epoch::chainstop(const name oracle)
+{
+   require_auth(oracle);
+   context ctx(get_self());
+
+   epoch::chain_table chains(get_self(), get_self().value);
+   const auto         chain_itr = chains.find(oracle.value);
+   check(chain_itr != chains.end(), "Oracle has no registered hash chain.");
+   check(!chain_itr->stopped_at, "Hash chain has already been stopped.");
+
+   // Epochs that already started keep expecting the oracle's chain reveal, the row stays until they are revealed
+   const auto     latest_itr = ctx.epochs.rbegin();
+   const uint64_t stopped_at = latest_itr != ctx.epochs.rend() ? latest_itr->epoch : 0;
+   if (stopped_at > chain_itr->epoch) {
+      chains.modify(chain_itr, oracle, [&](auto& row) { row.stopped_at = stopped_at; });
+   } else {
+      chains.erase(chain_itr);
+   }
+
+   const vector<name>& oracles    = get_oracle_set(ctx, get_active_oracle_set(ctx));
+   const auto          oracle_itr = find(oracles.begin(), oracles.end(), oracle);
+   if (oracle_itr != oracles.end()) {
+      clear_slot(ctx.state.chained, oracle_itr - oracles.begin());
+      epoch::state_table _state(get_self(), get_self().value);
+      _state.set(ctx.state, get_self());
+   }
+}
+
+[[eosio::action]] void epoch::chainreveal(const name oracle, const uint64_t epoch, const checksum256 reveal)
+{
+   require_auth(oracle);
+   context ctx(get_self());
+   check_is_enabled(ctx);
+
+   const epoch::epoch_row& _epoch = get_epoch(ctx, epoch);
+   const uint16_t          slot   = get_oracle_slot(ctx, _epoch, oracle);
+
+   if (epoch >= ctx.current_epoch_height) {
+      check(false, "Epoch (" + to_string(epoch) + ") has not completed.");
+   }
+   check(_epoch.status < EPOCH_STATUS_COMPLETE, "Epoch has already been revealed.");
+
+   ensure_epoch_advance(ctx);
+
+   check(!has_slot(_epoch.revealed, slot), "Oracle has already revealed");
+   check(has_slot(_epoch.committed, slot), "Oracle has not committed");
+
+   // Hashing the reveal once per epoch since the last link must arrive back at that link
+   epoch::chain_table chains(get_self(), get_self().value);
+   const auto&        chain = chains.get(oracle.value, "Oracle has no registered hash chain.");
+   if (epoch <= chain.epoch) {
+      check(false, "Hash chain has already been revealed past Epoch " + to_string(epoch) + ".");
+   }
+   if (chain.stopped_at && epoch > chain.stopped_at) {
+      check(false, "Hash chain was stopped at Epoch " + to_string(chain.stopped_at) + ".");
+   }
+   check(epoch - chain.epoch <= MAX_CHAIN_SKIP, "Hash chain link is too far behind, register a new chain.");
+
+   checksum256 link = reveal;
+   for (uint64_t i = chain.epoch; i < epoch; ++i) {
+      const auto bytes = link.extract_as_byte_array();
+      link             = sha256((const char*)bytes.data(), bytes.size());
+   }
+   if (link != chain.link) {
+      check(false, "Reveal value '" + checksum256_to_string(reveal) + "' does not hash to the last hash chain link '" +
+                      checksum256_to_string(chain.link) + "'.");
+   }
+
+   // A stopped chain is removed once it revealed the last epoch it was committed to
+   if (chain.stopped_at && epoch == chain.stopped_at) {
+      chains.erase(chain);
+   } else {
+      chains.modify(chain, oracle, [&](auto& row) {
+         row.link  = reveal;
+         row.epoch = epoch;
+      });
+   }
+
+   emplace_reveal(ctx, _epoch, slot, oracle, reveal);
+
+   ensure_epoch_reveal(ctx, _epoch);
+}
+
+epoch::commit_row epoch::prepare_reveal(context& ctx, const epoch_row& epoch_row, const uint16_t slot)
+{
+   const uint64_t current_epoch_height = ctx.current_epoch_height;
+   if (epoch_row.epoch >= current_epoch_height) {
+      check(false, "Epoch (" + to_string(epoch_row.epoch) + ") has not completed.");
+   }
+   check(epoch_row.status < EPOCH_STATUS_COMPLETE, "Epoch has already been revealed.");
+
+   ensure_epoch_advance(ctx);
+
+   check(!has_slot(epoch_row.revealed, slot), "Oracle has already revealed");
+
+   return get_commit(epoch_row.epoch, slot);
 }
 
 [[eosio::action]] void epoch::forcereveal(const uint64_t epoch, string salt)
 {
    require_auth(get_self());
-   check_is_enabled();
+   context ctx(get_self());
+   check_is_enabled(ctx);
 
-   const uint64_t current_epoch_height = get_current_epoch_height();
+   const uint64_t current_epoch_height = ctx.current_epoch_height;
    check(epoch < current_epoch_height, "Epoch (" + to_string(epoch) + ") has not completed.");
 
-   const epoch_row selected_epoch = get_epoch(epoch);
+   const epoch_row& selected_epoch = get_epoch(ctx, epoch);
 
-   check(checksum256_to_string(selected_epoch.seed) ==
-            "0000000000000000000000000000000000000000000000000000000000000000",
-         "Epoch has already been revealed and cannot be forced.");
+   check(selected_epoch.status < EPOCH_STATUS_COMPLETE, "Epoch has already been revealed and cannot be forced.");
 
    // Add the salt to the existing oracle reveals
-   vector<string> reveals = get_epoch_reveals(epoch);
-   reveals.push_back(salt);
+   const auto seed = compute_salted_seed(selected_epoch, salt);
+   complete_epoch(ctx, selected_epoch, seed, EPOCH_STATUS_FORCED);
+   cleanup_epoch(epoch);
+}
+
+[[eosio::action]] void epoch::finalize(const uint64_t epoch, const uint32_t max_rows)
+{
+   context ctx(get_self());
+   check_is_enabled(ctx);
+   check(max_rows > 0, "max_rows must be greater than 0.");
+
+   const epoch_row& selected_epoch = get_epoch(ctx, epoch);
+
+   // Already complete, only leftover rows from an earlier bounded call remain
+   if (selected_epoch.status >= EPOCH_STATUS_COMPLETE) {
+      check(cleanup_epoch(epoch, max_rows) > 0, "Epoch has already been finalized.");
+      return;
+   }
+
+   const block_timestamp end = get_epoch_start(ctx, epoch + 1);
+   if (current_time_point() < end.to_time_point() + seconds(ctx.state.grace_period)) {
+      check(false, "Epoch (" + to_string(epoch) + ") is still within its grace period.");
+   }
 
-   const auto seed = computehash(epoch, reveals);
-   complete_epoch(epoch, seed);
-   cleanup_epoch(epoch, selected_epoch.oracles);
+   // Without a single reveal the salted seed would be known to everyone in advance, close the epoch without a seed
+   if (selected_epoch.reveals == 0) {
+      ctx.epochs.modify(selected_epoch, get_self(), [&](auto& row) {
+         row.committed = {};
+         row.status    = EPOCH_STATUS_EMPTY;
+      });
+      cleanup_epoch(epoch, max_rows);
+      return;
+   }
+
+   // Finalize from the existing oracle reveals, salted with a value nobody can choose. The salt is public, so an
+   // oracle that withheld its reveal knew the forced seed in advance and chose between it and revealing.
+   const auto seed = compute_salted_seed(selected_epoch, get_finalize_salt(epoch));
+   complete_epoch(ctx, selected_epoch, seed, EPOCH_STATUS_FORCED);
+   cleanup_epoch(epoch, max_rows);
 }
 
-void epoch::check_is_enabled()
+[[eosio::action]] void epoch::prune(const uint32_t max_rows)
 {
-   epoch::state_table _state(get_self(), get_self().value);
-   const auto         state = _state.get_or_default();
-   check(state.enabled, ERROR_SYSTEM_DISABLED);
+   context ctx(get_self());
+   check(ctx.state.retention > 0, "Epoch retention is not configured.");
+   check(max_rows > 0, "max_rows must be greater than 0.");
+
+   // Epochs are erased oldest first and pruning stops at the first epoch that is not finished yet. An ended epoch
+   // without commits can never be revealed, so it is erased like a finished one.
+   uint32_t erased = 0;
+   auto     itr    = ctx.epochs.begin();
+   while (itr != ctx.epochs.end() && erased < max_rows && itr->epoch + ctx.state.retention < ctx.current_epoch_height) {
+      const bool finished = itr->status >= EPOCH_STATUS_COMPLETE || itr->commits == 0;
+      if (!finished || !is_empty_epoch<commit_table>(itr->epoch) || !is_empty_epoch<reveal_table>(itr->epoch)) {
+         break;
+      }
+      itr = ctx.epochs.erase(itr);
+      erased++;
+   }
+
+   // Set ids only grow, so sets older than both the oldest remaining epoch's set and the active set are unused
+   uint64_t oldest_set = ctx.state.oracle_set ? ctx.state.oracle_set : UINT64_MAX;
+   if (itr != ctx.epochs.end()) {
+      oldest_set = min(oldest_set, itr->oracle_set);
+   }
+   auto set_itr = ctx.oraclesets.begin();
+   while (set_itr != ctx.oraclesets.end() && erased < max_rows && set_itr->id < oldest_set) {
+      set_itr = ctx.oraclesets.erase(set_itr);
+      erased++;
+   }
+
+   check(erased > 0, "No epochs to prune.");
 }
 
-epoch::epoch_row epoch::get_epoch(const uint64_t epoch)
+string epoch::get_finalize_salt(const uint64_t epoch)
 {
-   epoch::epoch_table _epoch(get_self(), get_self().value);
-   const auto         epoch_itr = _epoch.find(epoch);
-   check(epoch_itr != _epoch.end(), "Epoch " + to_string(epoch) + " does not exist.");
+   const string data = "finalize:" + get_self().to_string() + ":" + to_string(epoch);
+   return checksum256_to_string(sha256(data.c_str(), data.length()));
+}
+
+void epoch::check_is_enabled(const context& ctx) { check(ctx.state.enabled, ERROR_SYSTEM_DISABLED); }
+
+const epoch::epoch_row& epoch::get_epoch(context& ctx, const uint64_t epoch)
+{
+   const auto epoch_itr = ctx.epochs.find(epoch);
+   if (epoch_itr == ctx.epochs.end()) {
+      if (is_skipped_epoch(ctx, epoch)) {
+         check(false, "Epoch " + to_string(epoch) + " was skipped, no oracle committed to it.");
+      }
+      check(false, "Epoch " + to_string(epoch) + " does not exist.");
+   }
    return *epoch_itr;
 }
 
-uint64_t epoch::get_current_epoch_height()
+epoch::segment_row epoch::get_segment(const context& ctx, const uint64_t epoch)
 {
-   epoch::state_table _state(get_self(), get_self().value);
-   const auto         state = _state.get_or_default();
-   return derive_epoch(state.genesis, state.duration);
+   // Before init, or after the segment table was wiped, the state's genesis and duration form the only segment
+   auto itr = ctx.segments.upper_bound(epoch);
+   if (itr == ctx.segments.begin()) {
+      return {1, ctx.state.genesis, ctx.state.duration};
+   }
+   return *--itr;
+}
+
+block_timestamp epoch::get_epoch_start(const context& ctx, const uint64_t epoch)
+{
+   const segment_row segment = get_segment(ctx, epoch);
+   return derive_epoch_start(segment.start, segment.duration, epoch - segment.epoch + 1);
+}
+
+bool epoch::is_skipped_epoch(const context& ctx, const uint64_t epoch)
+{
+   // Periods without any oracle activity never get a row, they are represented as empty epochs instead
+   const auto first_itr = ctx.epochs.begin();
+   return first_itr != ctx.epochs.end() && epoch > first_itr->epoch && epoch < ctx.current_epoch_height &&
+          ctx.epochs.find(epoch) == ctx.epochs.end();
+}
+
+uint16_t epoch::get_oracle_slot(const context& ctx, const epoch_row& epoch_row, const name oracle)
+{
+   const optional<uint16_t> slot = find_oracle_slot(ctx, epoch_row, oracle);
+   if (!slot) {
+      check(false, "Oracle is not in the list of oracles for Epoch " + to_string(epoch_row.epoch) + ".");
+   }
+   return *slot;
+}
+
+optional<uint16_t> epoch::find_oracle_slot(const context& ctx, const epoch_row& epoch_row, const name oracle)
+{
+   const vector<name>& oracles    = get_oracle_set(ctx, epoch_row.oracle_set);
+   const auto          oracle_itr = find(oracles.begin(), oracles.end(), oracle);
+   if (oracle_itr == oracles.end()) {
+      return {};
+   }
+   return oracle_itr - oracles.begin();
 }
 
-bool epoch::oracle_has_committed(const name oracle, const uint64_t epoch)
+const vector<name>& epoch::get_oracle_set(const context& ctx, const uint64_t oracle_set)
 {
-   epoch::commit_table commits(get_self(), get_self().value);
-   const auto          commit_idx = commits.get_index<"epochoracle"_n>();
-   const auto          commit_itr = commit_idx.find(((uint128_t)oracle.value << 64) + epoch);
-   return commit_itr != commit_idx.end();
+   // Rows read through the context's table stay cached for the rest of the action
+   return ctx.oraclesets.get(oracle_set, "Oracle set not found").oracles;
 }
 
-bool epoch::oracle_has_revealed(const name oracle, const uint64_t epoch)
+void epoch::publish_oracle_set()
 {
-   epoch::reveal_table reveals(get_self(), get_self().value);
-   const auto          reveal_idx = reveals.get_index<"epochoracle"_n>();
-   const auto          reveal_itr = reveal_idx.find(((uint128_t)oracle.value << 64) + epoch);
-   return reveal_itr != reveal_idx.end();
+   vector<name>        oracles;
+   epoch::oracle_table oracle_table(get_self(), get_self().value);
+   for (auto oracle_itr = oracle_table.begin(); oracle_itr != oracle_table.end(); oracle_itr++) {
+      oracles.push_back(oracle_itr->oracle);
+   }
+   check(oracles.size() <= MAX_ORACLES, "Too many oracles.");
+
+   // An empty registry is recorded as set 0 so epochs can check for active oracles without loading a set
+   uint64_t oracle_set = 0;
+   if (!oracles.empty()) {
+      epoch::oracleset_table oraclesets(get_self(), get_self().value);
+      oracle_set = max(oraclesets.available_primary_key(), (uint64_t)1);
+      oraclesets.emplace(get_self(), [&](auto& row) {
+         row.id      = oracle_set;
+         row.oracles = oracles;
+      });
+   }
+
+   // Carry active hash chain registrations over to the slots of the new set
+   epoch::chain_table chains(get_self(), get_self().value);
+   vector<uint8_t>    chained;
+   for (size_t slot = 0; slot < oracles.size(); ++slot) {
+      const auto chain_itr = chains.find(oracles[slot].value);
+      if (chain_itr != chains.end() && !chain_itr->stopped_at) {
+         set_slot(chained, slot);
+      }
+   }
+
+   epoch::state_table _state(get_self(), get_self().value);
+   auto               state = _state.get_or_default();
+   state.oracle_set         = oracle_set;
+   state.chained            = chained;
+   _state.set(state, get_self());
 }
 
-void epoch::emplace_commit(const uint64_t epoch, const name oracle, const checksum256 commit)
+void epoch::emplace_commit(
+   context& ctx, const epoch_row& epoch_row, const uint16_t slot, const name oracle, const checksum256 commit)
 {
-   epoch::commit_table commits(get_self(), get_self().value);
+   epoch::commit_table commits(get_self(), epoch_row.epoch);
    commits.emplace(oracle, [&](auto& row) {
-      row.id     = commits.available_primary_key();
-      row.epoch  = epoch;
-      row.oracle = oracle;
+      row.id     = slot;
       row.commit = commit;
    });
+
+   ctx.epochs.modify(epoch_row, get_self(), [&](auto& row) {
+      set_slot(row.committed, slot);
+      row.commits++;
+   });
 }
 
-void epoch::emplace_reveal(const uint64_t epoch, const name oracle, const string reveal)
+void epoch::emplace_reveal(context&          ctx,
+                           const epoch_row&  epoch_row,
+                           const uint16_t    slot,
+                           const name        oracle,
+                           const checksum256 reveal,
+                           const string&     legacy)
 {
-   epoch::reveal_table reveals(get_self(), get_self().value);
-   reveals.emplace(oracle, [&](auto& row) {
-      row.id     = reveals.available_primary_key();
-      row.epoch  = epoch;
-      row.oracle = oracle;
-      row.reveal = reveal;
+   // Accumulated epochs fold the verified reveal in right away and never store it
+   const bool accumulated = epoch_row.version == SEED_VERSION_ACCUMULATED;
+   if (!accumulated) {
+      epoch::reveal_table reveals(get_self(), epoch_row.epoch);
+      reveals.emplace(oracle, [&](auto& row) {
+         row.id     = slot;
+         row.reveal = reveal;
+         row.legacy = legacy;
+      });
+   }
+
+   ctx.epochs.modify(epoch_row, get_self(), [&](auto& row) {
+      set_slot(row.revealed, slot);
+      row.reveals++;
+      row.status = EPOCH_STATUS_REVEALING;
+      if (accumulated)
+         row.accumulator = add_checksum256(row.accumulator, reveal);
    });
 }
 
-void epoch::ensure_epoch_advance(const uint64_t current_epoch)
+void epoch::ensure_epoch_advance(context& ctx)
 {
-   // Attempt to find current epoch from state in oracle contract
-   epoch::epoch_table epochs(get_self(), get_self().value);
-   const auto         epochs_itr = epochs.find(current_epoch);
-
-   // If the epoch does not exist in the oracle contract, advance the epoch
-   if (epochs_itr == epochs.end()) {
-      epoch::advance_epoch();
+   // If the current epoch does not exist in the oracle contract, advance the epoch
+   if (ctx.epochs.find(ctx.current_epoch_height) == ctx.epochs.end()) {
+      epoch::advance_epoch(ctx);
    }
 }
 
-vector<name> epoch::get_active_oracles()
+uint64_t epoch::get_active_oracle_set(const context& ctx)
 {
-   vector<name>        oracles;
-   epoch::oracle_table oracle_table(get_self(), get_self().value);
-   auto                oracle_itr = oracle_table.begin();
-   check(oracle_itr != oracle_table.end(), "No active oracles");
-   while (oracle_itr != oracle_table.end()) {
-      oracles.push_back(oracle_itr->oracle);
-      oracle_itr++;
-   }
-   return oracles;
+   check(ctx.state.oracle_set != 0, "No active oracles");
+   return ctx.state.oracle_set;
 }
 
-epoch::epoch_row epoch::advance_epoch()
+epoch::epoch_row epoch::advance_epoch(context& ctx)
 {
-   const uint64_t current_epoch_height = get_current_epoch_height();
+   const uint64_t current_epoch_height = ctx.current_epoch_height;
 
-   epoch::epoch_table epochs(get_self(), get_self().value);
-   const auto         epochs_itr = epochs.find(current_epoch_height);
-   check(epochs_itr == epochs.end(), "Epoch " + to_string(current_epoch_height) + " is already initialized.");
+   const auto epochs_itr = ctx.epochs.find(current_epoch_height);
+   if (epochs_itr != ctx.epochs.end()) {
+      check(false, "Epoch " + to_string(current_epoch_height) + " is already initialized.");
+   }
 
-   const vector<name> oracles = get_active_oracles();
+   const uint64_t oracle_set = get_active_oracle_set(ctx);
 
-   epochs.emplace(get_self(), [&](auto& row) {
-      row.epoch   = current_epoch_height;
-      row.oracles = oracles;
+   // The latest epoch has ended and now only accepts reveals, skipped periods in between have no row
+   const auto previous_itr = ctx.epochs.rbegin();
+   if (previous_itr != ctx.epochs.rend() && previous_itr->status == EPOCH_STATUS_COLLECTING) {
+      ctx.epochs.modify(*previous_itr, get_self(), [&](auto& row) { row.status = EPOCH_STATUS_REVEALING; });
+   }
+
+   // Oracles with a registered hash chain are committed to every new epoch
+   const auto epoch_itr = ctx.epochs.emplace(get_self(), [&](auto& row) {
+      row.epoch      = current_epoch_height;
+      row.oracle_set = oracle_set;
+      row.committed  = ctx.state.chained;
+      row.commits    = count_slots(ctx.state.chained);
+      row.version    = ctx.state.seed_version;
    });
 
    // Return the next epoch
-   return {
-      current_epoch_height, // epoch
-      oracles,              // oracles
-   };
+   return *epoch_itr;
 }
 
 [[eosio::action]] epoch::epoch_row epoch::advance()
@@ -193,131 +554,212 @@ epoch::epoch_row epoch::advance_epoch()
    require_auth(get_self());
 
    // Advance the epoch
-   const auto new_epoch = advance_epoch();
+   context    ctx(get_self());
+   const auto new_epoch = advance_epoch(ctx);
 
    // Provide the epoch as a return value
    return new_epoch;
 }
 
-epoch::reveal_row epoch::get_reveal(const name oracle, const uint64_t epoch)
+epoch::commit_row epoch::get_commit(const uint64_t epoch, const uint16_t slot)
 {
-   epoch::reveal_table reveals(get_self(), get_self().value);
-   const auto          reveal_idx = reveals.get_index<"epochoracle"_n>();
-   const auto          reveal_itr = reveal_idx.find(((uint128_t)oracle.value << 64) + epoch);
-   check(reveal_itr != reveal_idx.end(), "Oracle has not revealed");
-   return *reveal_itr;
+   epoch::commit_table commits(get_self(), epoch);
+   const auto          commit_itr = commits.find(slot);
+   check(commit_itr != commits.end(), "Oracle has not committed");
+   return *commit_itr;
 }
 
-epoch::commit_row epoch::get_commit(const name oracle, const uint64_t epoch)
+template <typename T, typename F>
+void epoch::for_each_in_epoch(const uint64_t epoch, F&& callback)
 {
-   epoch::commit_table commits(get_self(), get_self().value);
-   const auto          commit_idx = commits.get_index<"epochoracle"_n>();
-   const auto          commit_itr = commit_idx.find(((uint128_t)oracle.value << 64) + epoch);
-   check(commit_itr != commit_idx.end(), "Oracle has not committed");
-   return *commit_itr;
+   const T table(get_self(), epoch);
+   for (auto itr = table.begin(); itr != table.end(); itr++) {
+      callback(*itr);
+   }
 }
 
-void epoch::remove_oracle_commit(const uint64_t epoch, const name oracle)
+template <typename T>
+bool epoch::is_empty_epoch(const uint64_t epoch)
 {
-   epoch::commit_table _commits(get_self(), get_self().value);
-   auto                commit_idx = _commits.get_index<"epochoracle"_n>();
-   auto                commit_itr = commit_idx.find(((uint128_t)oracle.value << 64) + epoch);
-   if (commit_itr != commit_idx.end()) {
-      commit_idx.erase(commit_itr);
-   }
+   const T table(get_self(), epoch);
+   return table.begin() == table.end();
 }
 
-void epoch::remove_oracle_reveal(const uint64_t epoch, const name oracle)
+template <typename T>
+uint64_t epoch::erase_in_epoch(const uint64_t epoch, const uint64_t max_rows)
 {
-   epoch::reveal_table _reveals(get_self(), get_self().value);
-   auto                reveal_idx = _reveals.get_index<"epochoracle"_n>();
-   auto                reveal_itr = reveal_idx.find(((uint128_t)oracle.value << 64) + epoch);
-   if (reveal_itr != reveal_idx.end()) {
-      reveal_idx.erase(reveal_itr);
+   uint64_t erased = 0;
+   T        table(get_self(), epoch);
+   auto     itr = table.begin();
+   while (itr != table.end() && erased < max_rows) {
+      itr = table.erase(itr);
+      erased++;
    }
+   return erased;
 }
 
-void epoch::cleanup_epoch(const uint64_t epoch, const vector<name> oracles)
+uint64_t epoch::cleanup_epoch(const uint64_t epoch, const uint64_t max_rows)
 {
-   for (const name oracle : oracles) {
-      remove_oracle_commit(epoch, oracle);
-      remove_oracle_reveal(epoch, oracle);
-   }
+   const uint64_t erased = erase_in_epoch<commit_table>(epoch, max_rows);
+   return erased + erase_in_epoch<reveal_table>(epoch, max_rows - erased);
 }
 
 vector<string> epoch::get_epoch_reveals(const uint64_t epoch)
 {
-   const epoch_row selected_epoch = get_epoch(epoch);
-   vector<string>  reveals;
+   vector<string> reveals;
+   for_each_in_epoch<reveal_table>(epoch, [&](const reveal_row& row) {
+      reveals.push_back(row.legacy.empty() ? checksum256_to_string(row.reveal) : row.legacy);
+   });
+   return reveals;
+}
 
-   const reveal_table _reveals(get_self(), get_self().value);
-   auto               idx       = _reveals.get_index<"epoch"_n>();
-   auto               itr_start = idx.lower_bound(epoch);
-   auto               itr_end   = idx.upper_bound(epoch);
+[[eosio::action, eosio::read_only]] checksum256 epoch::computehash(const uint64_t epoch, const vector<string> reveals)
+{
+   // Sort views of the reveal values alphebetically for consistency, the strings themselves are never copied
+   vector<string_view> sorted_reveals(reveals.begin(), reveals.end());
+   sort(sorted_reveals.begin(), sorted_reveals.end());
 
-   for (auto itr = idx.begin(); itr != idx.end(); itr++) {
-      if (itr->epoch != epoch)
-         continue;
-      reveals.push_back(itr->reveal);
-   }
+   // Combine the epoch and reveals into a single string, sized exactly before anything is appended
+   char         digits[20];
+   const size_t digits_length = uint64_to_chars(epoch, digits);
+   size_t       length        = digits_length;
+   for (const auto& reveal : sorted_reveals)
+      length += reveal.size();
 
-   return reveals;
+   string result;
+   result.reserve(length);
+   result.append(digits, digits_length);
+   for (const auto& reveal : sorted_reveals)
+      result.append(reveal.data(), reveal.size());
+
+   return sha256(result.data(), result.size());
 }
 
-vector<checksum256> epoch::get_epoch_commits(const uint64_t epoch)
+checksum256 epoch::compute_epoch_seed(const uint64_t epoch)
 {
-   const epoch_row     selected_epoch = get_epoch(epoch);
-   vector<checksum256> commits;
-
-   const commit_table _commits(get_self(), get_self().value);
-   auto               idx       = _commits.get_index<"epoch"_n>();
-   auto               itr_start = idx.lower_bound(epoch);
-   auto               itr_end   = idx.upper_bound(epoch);
+   // Stored reveals are fixed width binary, sorting their bytes gives the same order as sorting their hex strings
+   vector<array<uint8_t, 32>> reveals;
+   bool                       has_legacy = false;
+   for_each_in_epoch<reveal_table>(epoch, [&](const reveal_row& row) {
+      has_legacy |= !row.legacy.empty();
+      reveals.push_back(row.reveal.extract_as_byte_array());
+   });
 
-   for (auto itr = idx.begin(); itr != idx.end(); itr++) {
-      if (itr->epoch != epoch)
-         continue;
-      commits.push_back(itr->commit);
+   // Legacy string reveals sort among the hex strings, only then are all of them formatted as strings
+   if (has_legacy) {
+      return computehash(epoch, get_epoch_reveals(epoch));
    }
+   sort(reveals.begin(), reveals.end());
 
-   return commits;
+   // Same input as computehash, the reveals are hex encoded straight into their place in the buffer
+   char         digits[20];
+   const size_t digits_length = uint64_to_chars(epoch, digits);
+   string       result(digits_length + reveals.size() * 64, '0');
+   memcpy(&result[0], digits, digits_length);
+   for (size_t i = 0; i < reveals.size(); ++i)
+      hex_encode(reveals[i].data(), reveals[i].size(), &result[digits_length + i * 64]);
+
+   return sha256(result.data(), result.size());
 }
 
-[[eosio::action, eosio::read_only]] checksum256 epoch::computehash(const uint64_t epoch, const vector<string> reveals)
+checksum256 epoch::compute_salted_seed(const epoch_row& epoch_row, const string& salt)
 {
-   // Sort the reveal values alphebetically for consistency
-   vector<string> sorted_reveals = reveals;
-   sort(sorted_reveals.begin(), sorted_reveals.end());
+   if (epoch_row.version == SEED_VERSION_ACCUMULATED) {
+      const checksum256 salt_hash = sha256(salt.c_str(), salt.length());
+      return hash_seed_v2(epoch_row.epoch, add_checksum256(epoch_row.accumulator, salt_hash));
+   }
 
-   // Combine the epoch, drops, and reveals into a single string
-   string result = to_string(epoch);
-   for (const auto& reveal : sorted_reveals)
-      result += reveal;
+   vector<string> reveals = get_epoch_reveals(epoch_row.epoch);
+   reveals.push_back(salt);
+   return computehash(epoch_row.epoch, reveals);
+}
+
+[[eosio::action, eosio::read_only]] checksum256 epoch::computehash2(const uint64_t            epoch,
+                                                                   const vector<checksum256> reveals)
+{
+   checksum256 accumulator;
+   for (const auto& reveal : reveals)
+      accumulator = add_checksum256(accumulator, reveal);
 
-   return sha256(result.c_str(), result.length());
+   return hash_seed_v2(epoch, accumulator);
 }
 
-void epoch::complete_epoch(const uint64_t epoch, const checksum256 epoch_seed)
+void epoch::complete_epoch(context& ctx, const epoch_row& epoch_row, const checksum256 epoch_seed, const uint8_t status)
 {
-   epoch::epoch_table _epoch(get_self(), get_self().value);
-   auto&              epoch_row = _epoch.get(epoch, "Epoch not found");
-   _epoch.modify(epoch_row, get_self(), [&](auto& row) {
-      row.oracles = {};
-      row.seed    = epoch_seed;
+   const uint64_t leaf = append_seed(epoch_row.epoch, epoch_seed);
+   ctx.epochs.modify(epoch_row, get_self(), [&](auto& row) {
+      row.committed = {};
+      row.revealed  = {};
+      row.seed      = epoch_seed;
+      row.status    = status;
+      row.leaf      = leaf;
    });
 }
 
-void epoch::ensure_epoch_reveal(const uint64_t epoch)
+uint64_t epoch::append_seed(const uint64_t epoch, const checksum256 seed)
 {
-   const epoch_row           selected_epoch = get_epoch(epoch);
-   const vector<checksum256> commits        = get_epoch_commits(epoch);
-   const vector<string>      reveals        = get_epoch_reveals(epoch);
+   epoch::accumulator_table _accumulator(get_self(), get_self().value);
+   auto                     accumulator = _accumulator.get_or_default();
+
+   // Every trailing set bit of the size is a peak of equal height to the new node, merge them right to left
+   checksum256 node = hash_seed_leaf(epoch, seed);
+   for (uint64_t size = accumulator.size; size & 1; size >>= 1) {
+      node = hash_seed_node(accumulator.peaks.back(), node);
+      accumulator.peaks.pop_back();
+   }
+   accumulator.peaks.push_back(node);
+
+   const uint64_t leaf = accumulator.size++;
+   _accumulator.set(accumulator, get_self());
+   return leaf;
+}
 
-   if (reveals.size() == commits.size() && checksum256_to_string(selected_epoch.seed) ==
-                                              "0000000000000000000000000000000000000000000000000000000000000000") {
-      const auto seed = computehash(epoch, reveals);
-      complete_epoch(epoch, seed);
-      cleanup_epoch(epoch, selected_epoch.oracles);
+[[eosio::action, eosio::read_only]] bool
+epoch::verifyseed(const uint64_t epoch, const checksum256 seed, const uint64_t leaf, const vector<checksum256> proof)
+{
+   epoch::accumulator_table _accumulator(get_self(), get_self().value);
+   const auto               accumulator = _accumulator.get_or_default();
+   if (leaf >= accumulator.size) {
+      check(false, "Leaf " + to_string(leaf) + " does not exist.");
+   }
+
+   // Find the peak whose subtree covers the leaf, peaks are ordered from the highest subtree to the lowest
+   uint64_t offset = 0;
+   size_t   peak   = 0;
+   int      height = 64;
+   while (--height >= 0) {
+      const uint64_t width = uint64_t(1) << height;
+      if (!(accumulator.size & width))
+         continue;
+      if (leaf < offset + width)
+         break;
+      offset += width;
+      peak++;
+   }
+
+   if (proof.size() != static_cast<size_t>(height))
+      return false;
+
+   checksum256    node  = hash_seed_leaf(epoch, seed);
+   const uint64_t index = leaf - offset;
+   for (size_t i = 0; i < proof.size(); i++) {
+      node = (index >> i) & 1 ? hash_seed_node(proof[i], node) : hash_seed_node(node, proof[i]);
+   }
+   return node == accumulator.peaks[peak];
+}
+
+void epoch::ensure_epoch_reveal(context& ctx, const epoch_row& epoch_row)
+{
+   // Only load the reveals once every committed oracle has revealed, or once the configured threshold of reveals is
+   // reached. Reveals are counted in the order they were accepted, so the set used for the seed is deterministic.
+   const bool all_revealed  = epoch_row.reveals == epoch_row.commits;
+   const bool threshold_met = ctx.state.threshold > 0 && epoch_row.reveals >= ctx.state.threshold;
+   if ((all_revealed || threshold_met) && epoch_row.status < EPOCH_STATUS_COMPLETE) {
+      const auto seed = epoch_row.version == SEED_VERSION_ACCUMULATED
+                           ? hash_seed_v2(epoch_row.epoch, epoch_row.accumulator)
+                           : compute_epoch_seed(epoch_row.epoch);
+      complete_epoch(ctx, epoch_row, seed, EPOCH_STATUS_COMPLETE);
+      cleanup_epoch(epoch_row.epoch);
    }
 }
 
@@ -327,6 +769,8 @@ void epoch::ensure_epoch_reveal(const uint64_t epoch)
    check(is_account(oracle), "Account does not exist.");
    epoch::oracle_table oracles(get_self(), get_self().value);
    oracles.emplace(get_self(), [&](auto& row) { row.oracle = oracle; });
+
+   publish_oracle_set();
 }
 
 [[eosio::action]] void epoch::removeoracle(const name oracle)
@@ -337,6 +781,8 @@ void epoch::ensure_epoch_reveal(const uint64_t epoch)
    const auto          oracle_itr = oracles.find(oracle.value);
    check(oracle_itr != oracles.end(), "Oracle not found");
    oracles.erase(oracle_itr);
+
+   publish_oracle_set();
 }
 
 [[eosio::action]] void epoch::init()
@@ -353,21 +799,25 @@ void epoch::ensure_epoch_reveal(const uint64_t epoch)
    state.genesis = genesis;
    _state.set(state, get_self());
 
-   // Load oracles to initialize the first epoch
-   epoch::oracle_table oracle_table(get_self(), get_self().value);
-   vector<name>        oracles;
-   auto                oracle_itr = oracle_table.begin();
-   check(oracle_itr != oracle_table.end(), "No oracles registered, cannot init.");
-   while (oracle_itr != oracle_table.end()) {
-      oracles.push_back(oracle_itr->oracle);
-      oracle_itr++;
-   }
+   // The current oracle set initializes the first epoch
+   check(state.oracle_set != 0, "No oracles registered, cannot init.");
+
+   // The first segment of the duration schedule starts at genesis
+   epoch::segment_table segments(get_self(), get_self().value);
+   segments.emplace(get_self(), [&](auto& row) {
+      row.epoch    = 1;
+      row.start    = genesis;
+      row.duration = state.duration;
+   });
 
    // Add the initial epoch row to the oracle contract
    epoch::epoch_table epochs(get_self(), get_self().value);
    epochs.emplace(get_self(), [&](auto& row) {
-      row.epoch   = 1;
-      row.oracles = oracles;
+      row.epoch      = 1;
+      row.oracle_set = state.oracle_set;
+      row.committed  = state.chained;
+      row.commits    = count_slots(state.chained);
+      row.version    = state.seed_version;
    });
 }
 
@@ -386,40 +836,210 @@ void epoch::ensure_epoch_reveal(const uint64_t epoch)
 [[eosio::action]] void epoch::duration(const uint32_t duration)
 {
    require_auth(get_self());
+   check(duration > 0, "Duration must be greater than 0.");
+
+   context ctx(get_self());
+
+   // Once epochs exist, a new duration only applies from the next epoch onwards so past epochs keep their numbers
+   if (ctx.epochs.begin() != ctx.epochs.end()) {
+      if (ctx.segments.begin() == ctx.segments.end()) {
+         ctx.segments.emplace(get_self(), [&](auto& row) { row = ctx.current_segment; });
+      }
+
+      const uint64_t        next_epoch  = ctx.current_epoch_height + 1;
+      const block_timestamp start       = get_epoch_start(ctx, next_epoch);
+      const auto            segment_itr = ctx.segments.find(next_epoch);
+      if (segment_itr == ctx.segments.end()) {
+         ctx.segments.emplace(get_self(), [&](auto& row) {
+            row.epoch    = next_epoch;
+            row.start    = start;
+            row.duration = duration;
+         });
+      } else {
+         ctx.segments.modify(segment_itr, get_self(), [&](auto& row) { row.duration = duration; });
+      }
+   }
+
+   epoch::state_table _state(get_self(), get_self().value);
+   ctx.state.duration = duration;
+   _state.set(ctx.state, get_self());
+}
+
+// @admin
+[[eosio::action]] void epoch::threshold(const uint32_t threshold)
+{
+   require_auth(get_self());
+
+   // A single reveal would let the first oracle to reveal choose the seed
+   check(threshold == 0 || threshold >= 2, "Threshold must be 0 or at least 2.");
 
    epoch::state_table _state(get_self(), get_self().value);
    auto               state = _state.get_or_default();
-   state.duration           = duration;
+   state.threshold          = threshold;
    _state.set(state, get_self());
 }
 
-[[eosio::action, eosio::read_only]] uint64_t epoch::getepoch() { return get_current_epoch_height(); }
+// @admin
+[[eosio::action]] void epoch::graceperiod(const uint32_t grace_period)
+{
+   require_auth(get_self());
+
+   epoch::state_table _state(get_self(), get_self().value);
+   auto               state = _state.get_or_default();
+   state.grace_period       = grace_period;
+   _state.set(state, get_self());
+}
+
+// @admin
+[[eosio::action]] void epoch::retention(const uint32_t retention)
+{
+   require_auth(get_self());
+
+   epoch::state_table _state(get_self(), get_self().value);
+   auto               state = _state.get_or_default();
+   state.retention          = retention;
+   _state.set(state, get_self());
+}
+
+// @admin
+[[eosio::action]] void epoch::maxdrops(const uint32_t max_drops)
+{
+   require_auth(get_self());
+
+   epoch::state_table _state(get_self(), get_self().value);
+   auto               state = _state.get_or_default();
+   state.max_drops          = max_drops;
+   _state.set(state, get_self());
+}
+
+// @admin
+[[eosio::action]] void epoch::seedversion(const uint8_t seed_version)
+{
+   require_auth(get_self());
+   check(seed_version == SEED_VERSION_SORTED || seed_version == SEED_VERSION_ACCUMULATED, "Unknown seed version.");
+
+   epoch::state_table _state(get_self(), get_self().value);
+   auto               state = _state.get_or_default();
+   state.seed_version       = seed_version;
+   _state.set(state, get_self());
+}
+
+[[eosio::action, eosio::read_only]] uint64_t epoch::getepoch()
+{
+   const context ctx(get_self());
+   return ctx.current_epoch_height;
+}
 
 [[eosio::action, eosio::read_only]] epoch::epoch_info epoch::getepochinfo(const optional<uint64_t> epoch)
 {
-   uint64_t epoch_height = get_current_epoch_height();
+   context  ctx(get_self());
+   uint64_t epoch_height = ctx.current_epoch_height;
    if (epoch.has_value()) {
       epoch_height = *epoch;
    }
 
-   const dropssystem::epoch::epoch_table _epoch("epoch.drops"_n, "epoch.drops"_n.value);
-   dropssystem::epoch::state_table       _state("epoch.drops"_n, "epoch.drops"_n.value);
+   block_timestamp start = get_epoch_start(ctx, epoch_height);
+   block_timestamp end   = get_epoch_start(ctx, epoch_height + 1);
+
+   // A skipped epoch is empty, it has no seed and no participating oracles
+   if (is_skipped_epoch(ctx, epoch_height)) {
+      return {epoch_height, start, end, checksum256(), {}};
+   }
+
+   const epoch_row& epoch_row = get_epoch(ctx, epoch_height);
+   return {epoch_height, start, end, epoch_row.seed, get_oracle_set(ctx, epoch_row.oracle_set)};
+}
+
+[[eosio::action, eosio::read_only]] vector<epoch::seed_info> epoch::getseeds(const uint64_t start_epoch,
+                                                                            const uint32_t limit)
+{
+   if (limit == 0 || limit > MAX_SEEDS_QUERY) {
+      check(false, "limit must be between 1 and " + to_string(MAX_SEEDS_QUERY) + ".");
+   }
+
+   const context     ctx(get_self());
+   vector<seed_info> seeds;
+   seeds.reserve(limit);
+   for (auto itr = ctx.epochs.lower_bound(start_epoch); itr != ctx.epochs.end() && seeds.size() < limit; itr++) {
+      seeds.push_back(
+         {itr->epoch, get_epoch_start(ctx, itr->epoch), get_epoch_start(ctx, itr->epoch + 1), itr->seed, itr->status});
+   }
+   return seeds;
+}
+
+checksum256 epoch::get_epoch_seed(context& ctx, const uint64_t epoch)
+{
+   const epoch_row& epoch_row = get_epoch(ctx, epoch);
+   if (epoch_row.status < EPOCH_STATUS_COMPLETE) {
+      check(false, "Epoch " + to_string(epoch) + " has no seed yet.");
+   }
+   if (epoch_row.status == EPOCH_STATUS_EMPTY) {
+      check(false, "Epoch " + to_string(epoch) + " was finalized without a seed.");
+   }
+   return epoch_row.seed;
+}
+
+template <typename F>
+void epoch::score_drops(const context& ctx, const checksum256 seed, const vector<uint64_t>& drops, F&& callback)
+{
+   if (drops.size() > ctx.state.max_drops) {
+      check(false, "Too many drops, at most " + to_string(ctx.state.max_drops) + ".");
+   }
+
+   const array<char, 64> seed_hex = checksum256_to_hex(seed);
+   for (const uint64_t drop : drops) {
+      const checksum256 hash = hashdrop(seed_hex, drop);
+      callback(drop_score{drop, hash, clzbinary(hash)});
+   }
+}
+
+[[eosio::action, eosio::read_only]] vector<epoch::drop_score> epoch::scoredrops(const uint64_t         epoch,
+                                                                              const vector<uint64_t> drops)
+{
+   context           ctx(get_self());
+   const checksum256 seed = get_epoch_seed(ctx, epoch);
+
+   vector<drop_score> scores;
+   scores.reserve(drops.size());
+   score_drops(ctx, seed, drops, [&](const drop_score& score) { scores.push_back(score); });
+   return scores;
+}
+
+[[eosio::action, eosio::read_only]] vector<epoch::drop_score>
+epoch::topdrops(const uint64_t epoch, const vector<uint64_t> drops, const uint32_t k)
+{
+   check(k > 0, "k must be greater than 0.");
+
+   context           ctx(get_self());
+   const checksum256 seed = get_epoch_seed(ctx, epoch);
 
-   // Retrieve the current epoch being used (current - 1)
-   auto       state     = _state.get();
-   const auto epoch_row = get_epoch(epoch_height);
+   const auto better = [](const drop_score& a, const drop_score& b) {
+      return a.zeros > b.zeros || (a.zeros == b.zeros && a.hash < b.hash);
+   };
 
-   block_timestamp start = derive_epoch_start(state.genesis, state.duration, epoch_height);
-   block_timestamp end   = block_timestamp(start.to_time_point() + seconds(state.duration));
+   // Heap of the best k so far with the worst of them on top, only a better drop displaces it
+   vector<drop_score> top;
+   top.reserve(min<size_t>(k, drops.size()));
+   score_drops(ctx, seed, drops, [&](const drop_score& score) {
+      if (top.size() < k) {
+         top.push_back(score);
+         push_heap(top.begin(), top.end(), better);
+      } else if (better(score, top.front())) {
+         pop_heap(top.begin(), top.end(), better);
+         top.back() = score;
+         push_heap(top.begin(), top.end(), better);
+      }
+   });
 
-   return {epoch_height, start, end, epoch_row.seed, epoch_row.oracles};
+   sort_heap(top.begin(), top.end(), better);
+   return top;
 }
 
 [[eosio::action, eosio::read_only]] vector<name> epoch::getoracles()
 {
-   const uint64_t         current_epoch_height = get_current_epoch_height();
-   const epoch::epoch_row _epoch               = get_epoch(current_epoch_height);
-   return _epoch.oracles;
+   context          ctx(get_self());
+   const epoch_row& _epoch = get_epoch(ctx, ctx.current_epoch_height);
+   return get_oracle_set(ctx, _epoch.oracle_set);
 }
 
 } // namespace dropssystem
@@ -22,7 +22,7 @@ const blockchain = new Blockchain()
 const bob = 'bob'
 const alice = 'alice'
 const charlie = 'charlie'
-blockchain.createAccounts(bob, alice)
+blockchain.createAccounts(bob, alice, charlie)
 
 const core_contract = 'epoch.drops'
 const contracts = {
@@ -53,6 +53,45 @@ function getState(): EpochContract.Types.state_row {
     return EpochContract.Types.state_row.from(contracts.epoch.tables.state(scope).getTableRows()[0])
 }
 
+function getSegments(): EpochContract.Types.segment_row[] {
+    const scope = Name.from(core_contract).value.value
+    return contracts.epoch.tables
+        .segment(scope)
+        .getTableRows()
+        .map((row) => EpochContract.Types.segment_row.from(row))
+}
+
+function getAccumulator(): EpochContract.Types.accumulator_row {
+    const scope = Name.from(core_contract).value.value
+    return EpochContract.Types.accumulator_row.from(
+        contracts.epoch.tables.accumulator(scope).getTableRows()[0]
+    )
+}
+
+function seedLeaf(epoch: number, seed: Checksum256) {
+    const data = new Uint8Array(40)
+    new DataView(data.buffer).setBigUint64(0, BigInt(epoch), true)
+    data.set(seed.array, 8)
+    return Checksum256.hash(data)
+}
+
+function seedHashV2(epoch: number, reveals: string[]) {
+    const sum = reveals.reduce((acc, reveal) => (acc + BigInt('0x' + reveal)) % (1n << 256n), 0n)
+    const tag = Bytes.from('epoch.drops:seed:v2', 'utf8').array
+    const data = new Uint8Array(tag.length + 8 + 32)
+    data.set(tag, 0)
+    new DataView(data.buffer).setBigUint64(tag.length, BigInt(epoch), true)
+    data.set(Checksum256.from(sum.toString(16).padStart(64, '0')).array, tag.length + 8)
+    return Checksum256.hash(data)
+}
+
+function seedNode(left: Checksum256, right: Checksum256) {
+    const data = new Uint8Array(64)
+    data.set(left.array, 0)
+    data.set(right.array, 32)
+    return Checksum256.hash(data)
+}
+
 // function getBalance(account: string) {
 //     const scope = Name.from(account).value.value
 //     const primary_key = Asset.SymbolCode.from('EOS').value.value
@@ -71,14 +110,23 @@ function getEpochs(): EpochContract.Types.epoch_row[] {
     return rows.map((row) => EpochContract.Types.epoch_row.from(row))
 }
 
-function getCommits(): EpochContract.Types.commit_row[] {
-    const rows = contracts.epoch.tables.commit().getTableRows()
-    return rows.map((row) => EpochContract.Types.commit_row.from(row))
+// Commit and reveal rows are scoped by epoch
+function getCommits(epochs: bigint[] = [1n, 2n, 3n]): EpochContract.Types.commit_row[] {
+    return epochs.flatMap((epoch) =>
+        contracts.epoch.tables
+            .commit(epoch)
+            .getTableRows()
+            .map((row) => EpochContract.Types.commit_row.from(row))
+    )
 }
 
-function getReveals(): EpochContract.Types.reveal_row[] {
-    const rows = contracts.epoch.tables.reveal().getTableRows()
-    return rows.map((row) => EpochContract.Types.reveal_row.from(row))
+function getReveals(epochs: bigint[] = [1n, 2n, 3n]): EpochContract.Types.reveal_row[] {
+    return epochs.flatMap((epoch) =>
+        contracts.epoch.tables
+            .reveal(epoch)
+            .getTableRows()
+            .map((row) => EpochContract.Types.reveal_row.from(row))
+    )
 }
 
 // function getDrop(seed: bigint): DropsContract.Types.drop_row {
@@ -110,6 +158,38 @@ function getOracles(): EpochContract.Types.oracle_row[] {
         .map((row) => EpochContract.Types.oracle_row.from(row))
 }
 
+function getChain(oracle: string): EpochContract.Types.chain_row | undefined {
+    const scope = Name.from(core_contract).value.value
+    const row = contracts.epoch.tables.chain(scope).getTableRow(Name.from(oracle).value.value)
+    return row ? EpochContract.Types.chain_row.from(row) : undefined
+}
+
+function getOracleSet(id: bigint): EpochContract.Types.oracleset_row {
+    const scope = Name.from(core_contract).value.value
+    const row = contracts.epoch.tables.oracleset(scope).getTableRow(id)
+    if (!row) throw new Error('Oracle set not found')
+    return EpochContract.Types.oracleset_row.from(row)
+}
+
+// Reference implementations of the contract's hashdrop and clzbinary
+function hashDrop(seed: Checksum256, id: bigint) {
+    return Checksum256.hash(Bytes.from(seed.hexString + id.toString(), 'utf8').array)
+}
+
+function leadingZeros(hash: Checksum256) {
+    let zeros = 0
+    for (const byte of hash.array) {
+        if (byte !== 0) return zeros + Math.clz32(byte) - 24
+        zeros += 8
+    }
+    return zeros
+}
+
+// Read-only actions report their result as the return value of the last action trace
+function getReturnValue() {
+    return blockchain.actionTraces[blockchain.actionTraces.length - 1].returnValue
+}
+
 function revealHash(epoch: number, secrets: string[]) {
     const combined = [epoch, ...secrets.sort()].join('')
     return Checksum256.hash(Bytes.from(combined, 'utf8').array).hexString
@@ -128,12 +208,48 @@ const defaultState = {
     genesis: BlockTimestamp.from(datetime),
     duration: 86400,
     enabled: false,
+    oracle_set: 0,
+    chained: [],
+    threshold: 0,
+    grace_period: 86400,
+    retention: 0,
+    max_drops: 5000,
+    seed_version: 1,
 }
 
+// hashdrop of the epoch 1 seed from a single mockReveal, recorded with the to_string based
+// implementation for every change in digit count
+const hashdropVectors: [bigint, string][] = [
+    [0n, '3150eb8165d0ee79d77dcb77c9e480f8a8b80b56a6cc795e028fc31c5d8253a0'],
+    [9n, 'f24a31eb5498344b8dbce9bc595a025254e8925b9434a94d0f0be72559345775'],
+    [10n, 'd641a0c387c64c9eba7a705bd97f59e6eaa4fa4ceafb1233c403096ec8c36bed'],
+    [99n, 'a9a453ede8893bca6dc54799250d15dc13958531c7c806843ead2c2bbad9ed0c'],
+    [100n, '11c6f4d48b408537b5d9dc06a2b36c54ed52cd02426503da63203601f11b1e4b'],
+    [1000n, 'e3c411b6273b09db06833fc564fc14992194f212ca67a1baff73aa45cd9622e7'],
+    [10000n, 'f5e841acd337cf8f1c5f9d0eeb7064450ef0148c7a4bce4b11870ce410b8e6f1'],
+    [100000n, '2d52e71e0128d9a87275efd48bb927eb471d1d941efb975cc8bb418cfc35eeec'],
+    [1000000n, '348d0c9937c759e150a34287d9792518dbdcf7b318eed11962031aad37bfea3d'],
+    [10000000n, '124d4db0007a6c2c7c9aeb77794f17063390b32033ed2148598450ef068cc4ea'],
+    [100000000n, 'c60dccf49a8fe4241c0fefb3e1c58036d0ea86ccc893d09ec00fe5350050dd2e'],
+    [1000000000n, 'e31f90caffe4d4c82bf0c11c6581d78ac1ec14294da61b55117604ffdf8fcda9'],
+    [10000000000n, 'c44dbb1efcdc12fb35e1607560b0c9a41c900e73d03c95a42f01258361406edd'],
+    [100000000000n, 'c1bef56ab6d4efa238e798565b8e17dfe54ff38318aca11e80a78b1036c923a6'],
+    [1000000000000n, '5b920321de3bea16c651ae755ea76000599f32c1c2cc4fbbc4fbed45266bd77c'],
+    [10000000000000n, '5d7173d343c115cd6f234bf248e2e7a4ffdcd7cc9f38d3dc9cf2dd371a22c5c1'],
+    [100000000000000n, 'b0befbac51f9ac1bcd1ae0851df8ac1f6317fffb5677d9093de716ef276ca968'],
+    [1000000000000000n, '2c38a873f0fa320fbf5355f30e8fbf82a2340f80c89541f1e6b55a4555d3027b'],
+    [10000000000000000n, '3046e6e3fcd1c46f95706ee098dc0923f073a73ffbe182d32ac07da795111155'],
+    [100000000000000000n, 'd22706a953f870f85598acb508df9b4131dc9739ddbde1a53e6b239186797ab6'],
+    [1000000000000000000n, '3df921a7d3e3798816bc08477a7914bd85bd570604190eb49002fc885562cbd7'],
+    [10000000000000000000n, '3f3d819d911e08becea9f142f14598cc90d82d7cc14073587b064bd936f3e744'],
+    [18446744073709551615n, '84e0ad8ef5df766b6625f280c7b4d2fc4e6ccc980edad53da30fd835a6a902dc'],
+]
+
 // Sample random data (just a random key)
 const mockSecret = 'PVT_K1_dqeryoVTjBmXPtikBkjCFD4EMM1YdZTLQKqip8XUQHWyj9ZSD'
 const mockReveal = Checksum256.hash(Bytes.from(mockSecret, 'utf8').array).hexString
 const mockCommit = Checksum256.hash(Bytes.from(mockReveal, 'utf8').array).hexString
+const mockBinaryCommit = Checksum256.hash(Checksum256.from(mockReveal).array).hexString
 
 describe(core_contract, () => {
     // Setup before each test
@@ -153,6 +269,18 @@ describe(core_contract, () => {
         expect(expected).toBe(actual)
     })
 
+    test('computehash sorts unsorted reveals', async () => {
+        const reveals = [
+            '6ebbcfd600cb99737f3329aa4545ad6bf1cc62a86d9aaaebf6cc197c49b7064e',
+            '764c433a1b07827415b263d47ff468bc0a6b35754c878176038cf8dd2fabc90b',
+            '4086e35e0554c61ae225e71fd84327902b3da16fd54aa0cc186a7b1bf56578ab',
+        ]
+        await contracts.epoch.actions.computehash([146, reveals]).send()
+        expect(Checksum256.from(getReturnValue()).hexString).toBe(
+            '7f1c43edefe38ea54d678f3341cc12a9673f8c4c78fa1cdf3203f751deb07239'
+        )
+    })
+
     test('state::default', async () => {
         expect(getState()).toBeStruct(defaultState)
         expect(() => getEpoch(1n)).toThrow('Epoch not found')
@@ -163,8 +291,16 @@ describe(core_contract, () => {
         await contracts.epoch.actions.init().send()
         expect(getEpoch(1n)).toBeStruct({
             epoch: 1n,
+            oracle_set: 1,
             seed: '0000000000000000000000000000000000000000000000000000000000000000',
-            oracles: [alice],
+            commits: 0,
+            reveals: 0,
+            committed: [],
+            revealed: [],
+            status: 0,
+            leaf: 0,
+            version: 1,
+            accumulator: '0000000000000000000000000000000000000000000000000000000000000000',
         })
     })
 
@@ -189,6 +325,27 @@ describe(core_contract, () => {
         })
     })
 
+    test('duration after init applies from the next epoch', async () => {
+        await contracts.epoch.actions.addoracle([alice]).send()
+        await contracts.epoch.actions.init().send()
+        advanceTime(86400 + 100)
+
+        await contracts.epoch.actions.duration([3600]).send()
+        const segments = getSegments()
+        expect(segments.map((row) => Number(row.epoch))).toEqual([1, 3])
+        expect(segments[1].start.toMilliseconds()).toBe(
+            getState().genesis.toMilliseconds() + 2 * 86400 * 1000
+        )
+        expect(Number(segments[1].duration)).toBe(3600)
+
+        // Epoch 2 keeps its number and length, epoch 3 starts at the end of it
+        advanceTime(86400 - 100)
+        await contracts.epoch.actions.commit([alice, 3, mockCommit]).send(alice)
+        advanceTime(3600)
+        await contracts.epoch.actions.commit([alice, 4, mockCommit]).send(alice)
+        expect(Number(getEpoch(4n).epoch)).toBe(4)
+    })
+
     describe('oracle', () => {
         test('addoracle', async () => {
             await contracts.epoch.actions.addoracle([alice]).send()
@@ -204,6 +361,15 @@ describe(core_contract, () => {
             await contracts.epoch.actions.removeoracle([alice]).send()
             const afterRemove = getOracles()
             expect(afterRemove.length).toBe(0)
+            expect(getState().oracle_set.toNumber()).toBe(0)
+        })
+
+        test('publishes versioned oracle sets', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            expect(getState().oracle_set.toNumber()).toBe(2)
+            expect(getOracleSet(1n).oracles.map(String)).toEqual([alice])
+            expect(getOracleSet(2n).oracles.map(String)).toEqual([alice, bob])
         })
     })
 
@@ -218,8 +384,6 @@ describe(core_contract, () => {
             expect(commits.length).toBe(1)
             expect(commits[0]).toBeStruct({
                 id: 0,
-                epoch: 1,
-                oracle: 'alice',
                 commit: mockCommit,
             })
         })
@@ -375,6 +539,123 @@ describe(core_contract, () => {
                 )
             ).toBeTrue()
         })
+        test('tracks commit and reveal counts', async () => {
+            await contracts.epoch.actions.wipe().send()
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.init().send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, mockCommit]).send(bob)
+            expect(getEpoch(1n).commits.toNumber()).toBe(2)
+            expect(getEpoch(1n).reveals.toNumber()).toBe(0)
+            expect(getEpoch(1n).committed[0].toNumber()).toBe(0b11)
+
+            advanceTime(86400)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            expect(getEpoch(1n).reveals.toNumber()).toBe(1)
+        })
+        test('binary reveal', async () => {
+            await contracts.epoch.actions.wipe().send()
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.init().send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, mockBinaryCommit]).send(bob)
+            advanceTime(86400)
+
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            await contracts.epoch.actions.revealbin([bob, 1, mockReveal]).send(bob)
+
+            const epoch = getEpoch(1n)
+            expect(epoch.seed.equals(revealHash(1, [mockReveal, mockReveal]))).toBeTrue()
+        })
+        test('legacy string reveal', async () => {
+            await contracts.epoch.actions.wipe().send()
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.init().send()
+
+            // Secrets that are not lowercase hex still reveal and sort among the hex reveals
+            const upperReveal = mockReveal.toUpperCase()
+            const upperCommit = Checksum256.hash(Bytes.from(upperReveal, 'utf8').array).hexString
+            const fooCommit = Checksum256.hash(Bytes.from('foo', 'utf8').array).hexString
+            await contracts.epoch.actions.commit([alice, 1, upperCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, fooCommit]).send(bob)
+            advanceTime(86400)
+
+            await contracts.epoch.actions.reveal([alice, 1, upperReveal]).send(alice)
+            await contracts.epoch.actions.reveal([bob, 1, 'foo']).send(bob)
+
+            const epoch = getEpoch(1n)
+            expect(epoch.seed.equals(revealHash(1, [upperReveal, 'foo']))).toBeTrue()
+        })
+        test('tracks epoch status', async () => {
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            expect(getEpoch(1n).status.toNumber()).toBe(0)
+
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 2, mockCommit]).send(alice)
+            expect(getEpoch(1n).status.toNumber()).toBe(1)
+            expect(getEpoch(2n).status.toNumber()).toBe(0)
+
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            expect(getEpoch(1n).status.toNumber()).toBe(2)
+        })
+        test('commitreveal', async () => {
+            await contracts.epoch.actions.commit([alice, 1, mockBinaryCommit]).send(alice)
+            advanceTime(86400)
+
+            await contracts.epoch.actions
+                .commitreveal([alice, 2, mockBinaryCommit, mockReveal])
+                .send(alice)
+
+            expect(getEpoch(1n).seed.equals(revealHash(1, [mockReveal]))).toBeTrue()
+            expect(getCommits([2n]).length).toBe(1)
+        })
+        test('commitreveal skips reveal of a completed epoch', async () => {
+            await contracts.epoch.actions.wipe().send()
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.addoracle([charlie]).send()
+            await contracts.epoch.actions.init().send()
+            await contracts.epoch.actions.threshold([2]).send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockBinaryCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, mockBinaryCommit]).send(bob)
+            await contracts.epoch.actions.commit([charlie, 1, mockBinaryCommit]).send(charlie)
+            advanceTime(86400)
+            await contracts.epoch.actions.revealbin([alice, 1, mockReveal]).send(alice)
+            await contracts.epoch.actions.revealbin([charlie, 1, mockReveal]).send(charlie)
+            expect(getEpoch(1n).status.toNumber()).toBe(2)
+
+            await contracts.epoch.actions
+                .commitreveal([bob, 2, mockBinaryCommit, mockReveal])
+                .send(bob)
+
+            const seed = revealHash(1, [mockReveal, mockReveal])
+            expect(getEpoch(1n).seed.equals(seed)).toBeTrue()
+            expect(getEpoch(2n).commits.toNumber()).toBe(1)
+            expect(getEpoch(2n).committed[0].toNumber()).toBe(0b10)
+        })
+        test('commitreveal skips reveal without a previous commit', async () => {
+            await contracts.epoch.actions.wipe().send()
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.init().send()
+
+            await contracts.epoch.actions.commit([bob, 1, mockBinaryCommit]).send(bob)
+            advanceTime(86400)
+
+            await contracts.epoch.actions
+                .commitreveal([alice, 2, mockBinaryCommit, mockReveal])
+                .send(alice)
+
+            expect(getEpoch(1n).reveals.toNumber()).toBe(0)
+            expect(getEpoch(2n).commits.toNumber()).toBe(1)
+            expect(getEpoch(2n).committed[0].toNumber()).toBe(0b01)
+        })
         test('does not reveal until all oracles submit', async () => {
             await contracts.epoch.actions.wipe().send()
             await contracts.epoch.actions.addoracle([alice]).send()
@@ -456,7 +737,389 @@ describe(core_contract, () => {
         })
     })
 
+    describe('hash chain', () => {
+        // Chain links are generated forward from a secret and revealed in reverse order
+        const chain = [Checksum256.hash(Bytes.from(mockSecret, 'utf8').array)]
+        for (let i = 0; i < 5; i++) chain.push(Checksum256.hash(chain[i].array))
+        const tip = chain[5]
+
+        beforeEach(async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+        })
+        test('commits to every following epoch', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            expect(getEpoch(2n).commits.toNumber()).toBe(1)
+            expect(getCommits([2n]).length).toBe(0)
+        })
+        test('reveals the next preimage', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            advanceTime(86400)
+            await contracts.epoch.actions.chainreveal([alice, 2, chain[4]]).send(alice)
+            expect(getEpoch(2n).seed.equals(revealHash(2, [chain[4].hexString]))).toBeTrue()
+        })
+        test('reveal does not match chain', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            advanceTime(86400)
+            const action = contracts.epoch.actions.chainreveal([alice, 2, chain[1]]).send(alice)
+            expect(action).rejects.toThrow('does not hash to the last hash chain link')
+        })
+        test('skips epochs that were not revealed', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+
+            // Epoch 3 is two links behind the registered tip
+            await contracts.epoch.actions.chainreveal([alice, 3, chain[3]]).send(alice)
+            expect(getEpoch(3n).seed.equals(revealHash(3, [chain[3].hexString]))).toBeTrue()
+            expect(getChain(alice)?.epoch.toNumber()).toBe(3)
+
+            const action = contracts.epoch.actions.chainreveal([alice, 2, chain[4]]).send(alice)
+            expect(action).rejects.toThrow('Hash chain has already been revealed past Epoch 2.')
+        })
+        test('registers before the epoch row exists', async () => {
+            advanceTime(86400)
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+
+            // The current epoch is created before the chain, so it still needs a regular commit
+            expect(getEpoch(2n).commits.toNumber()).toBe(0)
+            expect(getChain(alice)?.epoch.toNumber()).toBe(2)
+            await contracts.epoch.actions.commit([alice, 2, mockCommit]).send(alice)
+
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            expect(getEpoch(3n).commits.toNumber()).toBe(1)
+        })
+        test('rejects registration while chain epochs are open', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+
+            const action = contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            expect(action).rejects.toThrow('Hash chain has not been revealed for Epoch 2.')
+        })
+        test('stop keeps serving in-flight epochs', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+
+            await contracts.epoch.actions.chainstop([alice]).send(alice)
+            expect(getChain(alice)?.stopped_at.toNumber()).toBe(2)
+            expect(getState().chained).toEqual([])
+
+            advanceTime(86400)
+            await contracts.epoch.actions.advance().send()
+            expect(getEpoch(3n).commits.toNumber()).toBe(0)
+
+            await contracts.epoch.actions.chainreveal([alice, 2, chain[4]]).send(alice)
+            expect(getEpoch(2n).status.toNumber()).toBe(2)
+            expect(getChain(alice)).toBeUndefined()
+        })
+        test('stop without chain epochs removes the chain', async () => {
+            await contracts.epoch.actions.chaininit([alice, tip]).send(alice)
+            await contracts.epoch.actions.chainstop([alice]).send(alice)
+            expect(getChain(alice)).toBeUndefined()
+        })
+    })
+
     describe('edge cases', () => {
+        test('finalizes once the reveal threshold is met', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.addoracle([charlie]).send()
+            await contracts.epoch.actions.init().send()
+            await contracts.epoch.actions.threshold([2]).send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, mockCommit]).send(bob)
+            await contracts.epoch.actions.commit([charlie, 1, mockCommit]).send(charlie)
+            advanceTime(86400)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            await contracts.epoch.actions.reveal([bob, 1, mockReveal]).send(bob)
+
+            const epoch = getEpoch(1n)
+            expect(epoch.seed.equals(revealHash(1, [mockReveal, mockReveal]))).toBeTrue()
+
+            const action = contracts.epoch.actions.reveal([charlie, 1, mockReveal]).send(charlie)
+            expect(action).rejects.toThrow('eosio_assert: Epoch has already been revealed.')
+        })
+        test('anyone finalizes a stalled epoch after the grace period', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.init().send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, mockCommit]).send(bob)
+            advanceTime(86400)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+
+            const early = contracts.epoch.actions.finalize([1, 10]).send(bob)
+            expect(early).rejects.toThrow(
+                'eosio_assert_message: Epoch (1) is still within its grace period.'
+            )
+
+            advanceTime(86400)
+            await contracts.epoch.actions.finalize([1, 1]).send(bob)
+
+            const salt = Checksum256.hash(Bytes.from('finalize:epoch.drops:1', 'utf8').array)
+            const epoch = getEpoch(1n)
+            expect(epoch.status.toNumber()).toBe(3)
+            expect(epoch.seed.equals(revealHash(1, [mockReveal, salt.hexString]))).toBeTrue()
+            expect(getCommits([1n]).length + getReveals([1n]).length).toBe(2)
+
+            await contracts.epoch.actions.finalize([1, 10]).send(bob)
+            expect(getCommits([1n]).length + getReveals([1n]).length).toBe(0)
+
+            const again = contracts.epoch.actions.finalize([1, 10]).send(bob)
+            expect(again).rejects.toThrow('eosio_assert: Epoch has already been finalized.')
+        })
+        test('finalizes an epoch without reveals as empty', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            advanceTime(86400 * 2)
+            await contracts.epoch.actions.finalize([1, 10]).send(bob)
+
+            const epoch = getEpoch(1n)
+            expect(epoch.status.toNumber()).toBe(4)
+            expect(epoch.seed.equals('0'.repeat(64))).toBeTrue()
+            const scope = Name.from(core_contract).value.value
+            expect(contracts.epoch.tables.accumulator(scope).getTableRows().length).toBe(0)
+            expect(getCommits([1n]).length).toBe(0)
+
+            const scored = contracts.epoch.actions.scoredrops([1, [1, 2, 3]]).send()
+            expect(scored).rejects.toThrow(
+                'eosio_assert_message: Epoch 1 was finalized without a seed.'
+            )
+            const again = contracts.epoch.actions.finalize([1, 10]).send(bob)
+            expect(again).rejects.toThrow('eosio_assert: Epoch has already been finalized.')
+        })
+        test('skipped epochs are empty', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            advanceTime(86400 * 4)
+
+            expect(() => getEpoch(3n)).toThrow('Epoch not found')
+            const action = contracts.epoch.actions.reveal([alice, 3, mockReveal]).send(alice)
+            expect(action).rejects.toThrow(
+                'eosio_assert_message: Epoch 3 was skipped, no oracle committed to it.'
+            )
+
+            await contracts.epoch.actions.commit([alice, 5, mockCommit]).send(alice)
+            expect(getEpoch(1n).status.toNumber()).toBe(1)
+
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            expect(getEpoch(1n).seed.equals(revealHash(1, [mockReveal]))).toBeTrue()
+        })
+        test('prunes completed epochs outside the retention window', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+            await contracts.epoch.actions.retention([1]).send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 2, mockCommit]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 3, mockCommit]).send(alice)
+
+            const pending = contracts.epoch.actions.prune([10]).send(bob)
+            expect(pending).rejects.toThrow('eosio_assert: No epochs to prune.')
+
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 2, mockReveal]).send(alice)
+            await contracts.epoch.actions.prune([10]).send(bob)
+
+            expect(getEpochs().map((row) => Number(row.epoch))).toEqual([2, 3])
+        })
+        test('prunes empty epochs in front of completed epochs', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+            await contracts.epoch.actions.retention([1]).send()
+            await contracts.epoch.actions.graceperiod([0]).send()
+
+            // Epoch 1 has no commits, epoch 2 is finalized without reveals
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 2, mockCommit]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 3, mockCommit]).send(alice)
+            await contracts.epoch.actions.finalize([2, 10]).send(bob)
+            expect(getEpoch(2n).status.toNumber()).toBe(4)
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 4, mockCommit]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 3, mockReveal]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 5, mockCommit]).send(alice)
+
+            expect(getEpoch(1n).commits.toNumber()).toBe(0)
+            await contracts.epoch.actions.prune([10]).send(bob)
+
+            expect(getEpochs().map((row) => Number(row.epoch))).toEqual([4, 5])
+        })
+        test('prune reclaims unused oracle sets', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+            await contracts.epoch.actions.retention([1]).send()
+
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.commit([alice, 2, mockCommit]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.removeoracle([bob]).send()
+            await contracts.epoch.actions.commit([alice, 3, mockCommit]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 2, mockReveal]).send(alice)
+
+            await contracts.epoch.actions.prune([10]).send(bob)
+
+            // Epoch 2 still uses set 2 and set 3 is active
+            expect(() => getOracleSet(1n)).toThrow('Oracle set not found')
+            expect(getOracleSet(2n).oracles.map(String)).toEqual([alice, bob])
+            expect(getOracleSet(3n).oracles.map(String)).toEqual([alice])
+        })
+        test('accumulates completed seeds', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+
+            for (let epoch = 1; epoch <= 3; epoch++) {
+                await contracts.epoch.actions.commit([alice, epoch, mockCommit]).send(alice)
+                advanceTime(86400)
+            }
+            await contracts.epoch.actions.reveal([alice, 2, mockReveal]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 3, mockReveal]).send(alice)
+
+            // Leaves follow completion order, not epoch order
+            expect(Number(getEpoch(2n).leaf)).toBe(0)
+            expect(Number(getEpoch(1n).leaf)).toBe(1)
+            expect(Number(getEpoch(3n).leaf)).toBe(2)
+
+            const leaf0 = seedLeaf(2, getEpoch(2n).seed)
+            const leaf1 = seedLeaf(1, getEpoch(1n).seed)
+            const leaf2 = seedLeaf(3, getEpoch(3n).seed)
+
+            const accumulator = getAccumulator()
+            expect(Number(accumulator.size)).toBe(3)
+            expect(accumulator.peaks.length).toBe(2)
+            expect(accumulator.peaks[0].equals(seedNode(leaf0, leaf1))).toBeTrue()
+            expect(accumulator.peaks[1].equals(leaf2)).toBeTrue()
+        })
+        test('verifies seeds against the accumulator', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+
+            for (let epoch = 1; epoch <= 3; epoch++) {
+                await contracts.epoch.actions.commit([alice, epoch, mockCommit]).send(alice)
+                advanceTime(86400)
+            }
+            await contracts.epoch.actions.reveal([alice, 2, mockReveal]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 3, mockReveal]).send(alice)
+
+            const seed1 = getEpoch(1n).seed
+            const seed2 = getEpoch(2n).seed
+            const leaf0 = seedLeaf(2, seed2)
+            const leaf1 = seedLeaf(1, seed1)
+            const leaf2 = seedLeaf(3, getEpoch(3n).seed)
+
+            await contracts.epoch.actions.verifyseed([2, seed2, 0, [leaf1]]).send()
+            expect(getReturnValue()).toBe(true)
+            await contracts.epoch.actions.verifyseed([3, getEpoch(3n).seed, 2, []]).send()
+            expect(getReturnValue()).toBe(true)
+
+            // Tampered seed
+            await contracts.epoch.actions.verifyseed([2, seed1, 0, [leaf1]]).send()
+            expect(getReturnValue()).toBe(false)
+
+            // Wrong leaf index
+            await contracts.epoch.actions.verifyseed([2, seed2, 1, [leaf1]]).send()
+            expect(getReturnValue()).toBe(false)
+
+            // Wrong sibling
+            await contracts.epoch.actions.verifyseed([2, seed2, 0, [leaf2]]).send()
+            expect(getReturnValue()).toBe(false)
+
+            const action = contracts.epoch.actions.verifyseed([2, seed2, 3, []]).send()
+            expect(action).rejects.toThrow('eosio_assert_message: Leaf 3 does not exist.')
+        })
+        test('getseeds limit', async () => {
+            const action = contracts.epoch.actions.getseeds([1, 0]).send()
+            expect(action).rejects.toThrow(
+                'eosio_assert_message: limit must be between 1 and 1000.'
+            )
+        })
+        test('getseeds pages through existing epochs', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+
+            for (let epoch = 1; epoch <= 3; epoch++) {
+                await contracts.epoch.actions.commit([alice, epoch, mockCommit]).send(alice)
+                advanceTime(86400)
+            }
+            // Epoch 4 is skipped
+            advanceTime(86400)
+            await contracts.epoch.actions.commit([alice, 5, mockCommit]).send(alice)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+
+            const getSeeds = async (start_epoch: number, limit: number) => {
+                await contracts.epoch.actions.getseeds([start_epoch, limit]).send()
+                return getReturnValue().map((row) => EpochContract.Types.seed_info.from(row))
+            }
+            const epochStart = (epoch: number) =>
+                BlockTimestamp.from(new Date(datetime.getTime() + (epoch - 1) * 86400 * 1000))
+
+            const seeds = await getSeeds(0, 10)
+            expect(seeds.map((row) => Number(row.epoch))).toEqual([1, 2, 3, 5])
+            for (const row of seeds) {
+                expect(row.start.equals(epochStart(Number(row.epoch)))).toBeTrue()
+                expect(row.end.equals(epochStart(Number(row.epoch) + 1))).toBeTrue()
+            }
+            expect(seeds[0].seed.equals(revealHash(1, [mockReveal]))).toBeTrue()
+            expect(seeds[0].status.toNumber()).toBe(2)
+
+            const page = await getSeeds(2, 2)
+            expect(page.map((row) => Number(row.epoch))).toEqual([2, 3])
+
+            // Pruned epochs are no longer listed
+            await contracts.epoch.actions.retention([1]).send()
+            await contracts.epoch.actions.prune([10]).send(bob)
+            expect((await getSeeds(0, 10)).map((row) => Number(row.epoch))).toEqual([2, 3, 5])
+            expect((await getSeeds(4, 10)).map((row) => Number(row.epoch))).toEqual([5])
+        })
+        test('seed version 2 accumulates reveals without storing them', async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.addoracle([bob]).send()
+            await contracts.epoch.actions.seedversion([2]).send()
+            await contracts.epoch.actions.init().send()
+            expect(getEpoch(1n).version.toNumber()).toBe(2)
+
+            const bobReveal = Checksum256.hash(Bytes.from('bob secret', 'utf8').array).hexString
+            const bobCommit = Checksum256.hash(Checksum256.from(bobReveal).array).hexString
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            await contracts.epoch.actions.commit([bob, 1, bobCommit]).send(bob)
+            advanceTime(86400)
+
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+            expect(getReveals([1n]).length).toBe(0)
+            await contracts.epoch.actions.revealbin([bob, 1, bobReveal]).send(bob)
+
+            const epoch = getEpoch(1n)
+            expect(epoch.status.toNumber()).toBe(2)
+            expect(epoch.seed.equals(seedHashV2(1, [mockReveal, bobReveal]))).toBeTrue()
+        })
         test('reveals despite missing oracle', async () => {
             await contracts.epoch.actions.addoracle([alice]).send()
             await contracts.epoch.actions.addoracle([bob]).send()
@@ -486,6 +1149,87 @@ describe(core_contract, () => {
 
             const epoch = getEpoch(1n)
             expect(epoch.seed.equals(revealHash(1, [mockReveal, 'foo']))).toBeTrue()
+            expect(epoch.status.toNumber()).toBe(3)
+        })
+    })
+
+    describe('drop scoring', () => {
+        beforeEach(async () => {
+            await contracts.epoch.actions.addoracle([alice]).send()
+            await contracts.epoch.actions.init().send()
+            await contracts.epoch.actions.commit([alice, 1, mockCommit]).send(alice)
+            advanceTime(86400)
+            await contracts.epoch.actions.reveal([alice, 1, mockReveal]).send(alice)
+        })
+        test('scoredrops requires a seed', async () => {
+            const action = contracts.epoch.actions.scoredrops([2, [1, 2, 3]]).send()
+            expect(action).rejects.toThrow('eosio_assert_message: Epoch 2 has no seed yet.')
+        })
+        test('scoredrops scores drops against the epoch seed', async () => {
+            const seed = getEpoch(1n).seed
+            const drops = [1n, 42n, 1000n, 18446744073709551615n]
+            await contracts.epoch.actions.scoredrops([1, drops]).send()
+            const scores = getReturnValue().map((row) => EpochContract.Types.drop_score.from(row))
+
+            expect(scores.map((row) => BigInt(row.drop.toString()))).toEqual(drops)
+            for (const row of scores) {
+                const expected = hashDrop(seed, BigInt(row.drop.toString()))
+                expect(row.hash.equals(expected)).toBeTrue()
+                expect(row.zeros.toNumber()).toBe(leadingZeros(expected))
+            }
+        })
+        test('topdrops respects the maximum input size', async () => {
+            await contracts.epoch.actions.maxdrops([2]).send()
+            const action = contracts.epoch.actions.topdrops([1, [1, 2, 3], 1]).send()
+            expect(action).rejects.toThrow('eosio_assert_message: Too many drops, at most 2.')
+
+            await contracts.epoch.actions.maxdrops([3]).send()
+            expect(getState().max_drops.toNumber()).toBe(3)
+            await contracts.epoch.actions.topdrops([1, [1, 2, 3], 1]).send()
+        })
+        test('hashdrop matches vectors from before the digit pair formatter', async () => {
+            expect(getEpoch(1n).seed.hexString).toBe(
+                'aa64858f9aef574443d0595ef57665d4252475b3f9a5a484c40654401a4116e5'
+            )
+
+            const drops = hashdropVectors.map(([drop]) => drop)
+            await contracts.epoch.actions.scoredrops([1, drops]).send()
+            const scores = getReturnValue().map((row) => EpochContract.Types.drop_score.from(row))
+
+            expect(scores.map((row) => row.hash.hexString)).toEqual(
+                hashdropVectors.map(([, hash]) => hash)
+            )
+        })
+        test('topdrops returns the best drops first', async () => {
+            // Most leading zero bits first, ties go to the lower hash
+            const seed = getEpoch(1n).seed
+            const drops = Array.from({length: 50}, (_, i) => BigInt(i + 1))
+            const expected = drops
+                .map((drop) => ({drop, hash: hashDrop(seed, drop)}))
+                .map((row) => ({...row, zeros: leadingZeros(row.hash)}))
+                .sort((a, b) => b.zeros - a.zeros || (a.hash.hexString < b.hash.hexString ? -1 : 1))
+            const ties = expected.filter((row, i) => i > 0 && row.zeros === expected[i - 1].zeros)
+            expect(ties.length).toBeGreaterThan(0)
+
+            const getTop = async (k: number) => {
+                await contracts.epoch.actions.topdrops([1, drops, k]).send()
+                return getReturnValue().map((row) => EpochContract.Types.drop_score.from(row))
+            }
+
+            for (const k of [5, 50, 80]) {
+                const top = await getTop(k)
+                expect(top.length).toBe(Math.min(k, drops.length))
+                expect(top.map((row) => BigInt(row.drop.toString()))).toEqual(
+                    expected.slice(0, k).map((row) => row.drop)
+                )
+                for (let i = 1; i < top.length; i++) {
+                    const [prev, next] = [top[i - 1], top[i]]
+                    expect(prev.zeros.toNumber()).toBeGreaterThanOrEqual(next.zeros.toNumber())
+                    if (prev.zeros.equals(next.zeros)) {
+                        expect(prev.hash.hexString < next.hash.hexString).toBeTrue()
+                    }
+                }
+            }
         })
     })
 
@@ -506,5 +1250,29 @@ describe(core_contract, () => {
             const action = contracts.epoch.actions.removeoracle([alice]).send(alice)
             expect(action).rejects.toThrow('missing required authority epoch.drops')
         })
+        test('threshold', async () => {
+            const action = contracts.epoch.actions.threshold([2]).send(alice)
+            expect(action).rejects.toThrow('missing required authority epoch.drops')
+        })
+        test('threshold rejects a single reveal', async () => {
+            const action = contracts.epoch.actions.threshold([1]).send()
+            expect(action).rejects.toThrow('eosio_assert: Threshold must be 0 or at least 2.')
+        })
+        test('graceperiod', async () => {
+            const action = contracts.epoch.actions.graceperiod([0]).send(alice)
+            expect(action).rejects.toThrow('missing required authority epoch.drops')
+        })
+        test('retention', async () => {
+            const action = contracts.epoch.actions.retention([1]).send(alice)
+            expect(action).rejects.toThrow('missing required authority epoch.drops')
+        })
+        test('maxdrops', async () => {
+            const action = contracts.epoch.actions.maxdrops([1]).send(alice)
+            expect(action).rejects.toThrow('missing required authority epoch.drops')
+        })
+        test('seedversion', async () => {
+            const action = contracts.epoch.actions.seedversion([2]).send(alice)
+            expect(action).rejects.toThrow('missing required authority epoch.drops')
+        })
     })
 })
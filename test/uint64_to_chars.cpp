@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <string>
+#include <epoch.drops/uint64_to_chars.hpp>
+
+// Drop ids are hashed as decimal text, so uint64_to_chars has to write exactly what std::to_string writes
+
+using dropssystem::uint64_to_chars;
+
+static uint64_t failures = 0;
+
+static void check(const uint64_t value)
+{
+   char         out[20] = {};
+   const size_t length  = uint64_to_chars(value, out);
+   if (std::string(out, length) != std::to_string(value)) {
+      if (++failures <= 10)
+         std::printf("%llu formatted as %.*s\n", static_cast<unsigned long long>(value), static_cast<int>(length), out);
+   }
+}
+
+// splitmix64, a fixed sequence so every run checks the same values
+static uint64_t next(uint64_t& state)
+{
+   uint64_t z = (state += 0x9e3779b97f4a7c15);
+   z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+   z          = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+   return z ^ (z >> 31);
+}
+
+int main()
+{
+   uint64_t checked = 0;
+
+   // Every value up to ten million
+   for (uint64_t value = 0; value < 10000000; value++, checked++)
+      check(value);
+
+   // Both sides of every change in digit count, and the largest values
+   for (uint64_t power = 10; power <= 1000000000000000000; power *= 10) {
+      for (uint64_t offset = 0; offset < 1000; offset++, checked += 2) {
+         check(power - 1 - offset);
+         check(power + offset);
+      }
+   }
+   for (uint64_t offset = 0; offset < 1000000; offset++, checked += 2) {
+      check(10000000000000000000ULL + offset);
+      check(UINT64_MAX - offset);
+   }
+
+   // Random values of every length
+   uint64_t state = 0;
+   for (uint64_t i = 0; i < 10000000; i++, checked++)
+      check(next(state) >> (i % 64));
+
+   std::printf("%llu values, %llu failures\n", static_cast<unsigned long long>(checked),
+               static_cast<unsigned long long>(failures));
+   return failures ? 1 : 0;
+}